@@ -0,0 +1,132 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <defs.h>
+#include <boot.h>
+#include <types.h>
+#include <acpi.h>
+#include <tags.h>
+
+/*
+ * ACPI tables aren't measured and can be modified before the launch, so
+ * everything read from them must be checked.  Only tables below 4G are used,
+ * that's all that is mapped.
+ */
+
+static u8 checksum(const void *p, u32 len)
+{
+    const u8 *b = p;
+    u8 sum = 0;
+
+    while ( len-- )
+        sum += *b++;
+
+    return sum;
+}
+
+static struct acpi_rsdp *scan_rsdp(uintptr_t start, uintptr_t end)
+{
+    for ( ; start + sizeof(struct acpi_rsdp) <= end; start += 16 )
+    {
+        struct acpi_rsdp *rsdp = _p(start);
+
+        if ( rsdp->signature == ACPI_SIG_RSDP &&
+             checksum(rsdp, offsetof(struct acpi_rsdp, length)) == 0 )
+            return rsdp;
+    }
+
+    return NULL;
+}
+
+static struct acpi_rsdp *find_rsdp(void)
+{
+    struct skl_tag_acpi_rsdp *t = next_of_type(&bootloader_data,
+                                               SKL_TAG_ACPI_RSDP);
+    u16 *ebda_ptr = _p(ACPI_EBDA_PTR);
+    struct acpi_rsdp *rsdp = NULL;
+    uintptr_t ebda;
+
+    /* The bootloader knows better, e.g. from the UEFI configuration table */
+    if ( t != NULL )
+        return t->address < (1ULL << 32) - sizeof(*rsdp) ?
+               scan_rsdp(t->address, t->address + sizeof(*rsdp)) : NULL;
+
+    /* Hide the constant from GCC, it treats addresses below 4k as NULL. */
+    asm ("" : "+r" (ebda_ptr));
+    ebda = (uintptr_t)*ebda_ptr << 4;
+
+    if ( ebda >= 0x400 && ebda < ACPI_BIOS_ROM_START )
+        rsdp = scan_rsdp(ebda, ebda + 0x400);
+
+    if ( rsdp == NULL )
+        rsdp = scan_rsdp(ACPI_BIOS_ROM_START, ACPI_BIOS_ROM_END);
+
+    return rsdp;
+}
+
+static struct acpi_table_header *valid_table(u64 addr, u32 *length)
+{
+    struct acpi_table_header *t;
+    u32 len;
+
+    if ( addr == 0 || addr >= (1ULL << 32) )
+        return NULL;
+
+    t = _p(addr);
+    len = READ_ONCE(t->length);
+    if ( len < sizeof(*t) || addr + len > (1ULL << 32) ||
+         checksum(t, len) != 0 )
+        return NULL;
+
+    *length = len;
+    return t;
+}
+
+void *acpi_find_table(u32 signature, u32 *length)
+{
+    struct acpi_rsdp *rsdp = find_rsdp();
+    struct acpi_table_header *sdt;
+    unsigned int i, n, entry_size;
+    u32 len;
+
+    if ( rsdp == NULL )
+        return NULL;
+
+    if ( rsdp->revision >= 2 &&
+         checksum(rsdp, sizeof(*rsdp)) == 0 &&
+         (sdt = valid_table(rsdp->xsdt_address, &len)) != NULL )
+        entry_size = sizeof(u64);
+    else if ( (sdt = valid_table(rsdp->rsdt_address, &len)) != NULL )
+        entry_size = sizeof(u32);
+    else
+        return NULL;
+
+    n = (len - sizeof(*sdt)) / entry_size;
+
+    for ( i = 0; i < n; i++ )
+    {
+        void *entry = _p(sdt + 1) + i * entry_size;
+        u64 addr = entry_size == sizeof(u64) ? READ_ONCE(*(u64 *)entry)
+                                              : READ_ONCE(*(u32 *)entry);
+
+        /* Check the signature first, to avoid summing every table */
+        if ( addr != 0 && addr < (1ULL << 32) &&
+             ((struct acpi_table_header *)_p(addr))->signature == signature )
+            return valid_table(addr, length);
+    }
+
+    return NULL;
+}
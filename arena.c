@@ -0,0 +1,79 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <defs.h>
+#include <boot.h>
+#include <types.h>
+#include <printk.h>
+#include <arena.h>
+
+#ifdef __x86_64__
+/* From head.S, map_gigabytes() makes L3[i] a 1G page if L2 table i is unused */
+extern u64 l2_identmap[4 * 512];
+extern u64 l3_identmap[512];
+#endif
+
+/* From link.lds */
+extern u8 _arena_start[], _arena_end[];
+
+static u8 *arena_next, *arena_limit;
+
+void arena_init(void)
+{
+    arena_next = _arena_start;
+    arena_limit = _arena_end;
+
+#ifdef __x86_64__
+    /* Rather the longest run of unused L2 tables, which is larger */
+    for ( unsigned int i = 0, first = 0, best = 0; i < 4; i++ )
+    {
+        if ( !(l3_identmap[i] & _PAGE_PSE) )
+            first = i + 1;
+        else if ( i + 1 - first > best )
+        {
+            best = i + 1 - first;
+            arena_next = (u8 *)&l2_identmap[first * 512];
+            arena_limit = (u8 *)&l2_identmap[(i + 1) * 512];
+        }
+    }
+#endif
+}
+
+void *arena_alloc(u32 size)
+{
+    u8 *p = arena_next;
+
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if ( size > arena_limit - p )
+    {
+        print("Out of arena memory\n");
+        die();
+    }
+
+    arena_next += size;
+
+    return p;
+}
+
+void arena_free(void *p)
+{
+    arena_next = p;
+}
+
+u32 arena_avail(void)
+{
+    return arena_limit - arena_next;
+}
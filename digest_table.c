@@ -0,0 +1,98 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include <defs.h>
+#include <boot.h>
+#include <types.h>
+#include <errno-base.h>
+#include <string.h>
+#include <tags.h>
+#include <paging.h>
+#include <digest_table.h>
+
+static struct skl_digest_table *table;
+static u32 max_entries;
+
+int digest_table_init(void)
+{
+    struct skl_tag_digest_table *t = next_of_type(&bootloader_data,
+                                                  SKL_TAG_DIGEST_TABLE);
+    void *p;
+
+    if ( t == NULL )
+        return 0;
+
+    if ( next_of_type(t, SKL_TAG_DIGEST_TABLE) != NULL ||
+         t->size < sizeof(*table) )
+        return -EINVAL;
+
+    p = map_phys(t->address, t->size);
+    if ( p == NULL )
+        return -EINVAL;
+
+    /* As for the event log, SKL mustn't be made to overwrite itself. */
+    if ( !(p + t->size <= _p(_start) || _p(_start + SLB_SIZE) <= p) )
+        return -EINVAL;
+
+    table = p;
+    max_entries = (t->size - sizeof(*table)) / sizeof(table->entries[0]);
+
+    /* Only the header, the entries are written as they're added. */
+    *table = (struct skl_digest_table){
+        .magic = SKL_DIGEST_TABLE_MAGIC,
+        .version = SKL_DIGEST_TABLE_VERSION,
+    };
+
+    return 0;
+}
+
+void digest_table_add(const void *data, u64 size, u8 pcr, u16 algo_id,
+                      const u8 *digest, u32 digest_size)
+{
+    struct skl_digest_entry *e;
+
+    if ( table == NULL )
+        return;
+
+    if ( table->count == max_entries || table->count == 0xffff )
+    {
+        table->flags |= SKL_DIGEST_TABLE_TRUNCATED;
+        return;
+    }
+
+    e = &table->entries[table->count++];
+    *e = (struct skl_digest_entry){
+        .address = _u(data),
+        .length = size,
+        .algo_id = algo_id,
+        .pcr = pcr,
+    };
+    memcpy(e->digest, digest, digest_size);
+}
+
+void *digest_table_finish(u32 *size)
+{
+    struct skl_digest_table *t = table;
+
+    if ( t == NULL )
+        return NULL;
+
+    table = NULL;
+    *size = sizeof(*t) + t->count * sizeof(t->entries[0]);
+
+    return t;
+}
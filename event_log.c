@@ -19,27 +19,24 @@
 #include <boot.h>
 #include <string.h>
 #include <tags.h>
+#include <paging.h>
 #include "tpmlib/tpm.h"
 #include "tpmlib/tpm2_constants.h"
+#include <event_log.h>
 
-static u8 *evtlog_base;
 static u8 *ptr_current;
 static u8 *limit;
 
-#define HAS_ENOUGH_SPACE(n)      ((limit - ptr_current) > (n))
+/*
+ * next_event_offset or next_record_offset, in the log's own header.  It is
+ * unaligned, so only accessed with memcpy().
+ */
+static u8 *next_offset;
 
-static int log_write(const void *data, unsigned size)
-{
-    if ( size >= limit - ptr_current )
-        return 1;
+/* Size of a TPM2.0 record without its event data, from the banks logged */
+static u32 tpm20_record_size;
 
-    memcpy(ptr_current, data, size);
-    ptr_current += size;
-    return 0;
-}
-
-#define EV_NO_ACTION    0x3
-#define EV_TYPE_SLAUNCH 0x502
+#define HAS_ENOUGH_SPACE(n)      ((limit - ptr_current) > (n))
 
 #define HASH_COUNT 2
 
@@ -155,68 +152,121 @@ static tpm20_spec_id_ev_t tpm20_id_struct = {
     .el.next_record_offset = sizeof(tpm20_spec_id_ev_t) + sizeof(tpm12_event_t)
 };
 
-int log_event_tpm12(u32 pcr, u8 sha1[20], char *event)
+/*
+ * The log isn't cleared up front, instead what follows the last record is
+ * zeroed every time one is added.  A parser then finds a record with no PCR,
+ * type or digests there, and stops.
+ */
+#define EVTLOG_SENTINEL          sizeof(tpm12_event_t)
+
+static u8 *put(u8 *p, const void *data, u32 size)
 {
-    tpm12_event_t ev;
-    tpm12_spec_id_ev_t *base = (tpm12_spec_id_ev_t *)
-                                (evtlog_base + sizeof(tpm12_event_t));
+    memcpy(p, data, size);
+    return p + size;
+}
 
-    ev.event_size = strlen(event);
+static void log_terminate(void)
+{
+    u32 left = limit - ptr_current;
 
-    if ( HAS_ENOUGH_SPACE(sizeof(ev) + ev.event_size) )
-    {
-        ev.pcr = pcr;
-        ev.event_type = EV_TYPE_SLAUNCH;
-        memcpy(ev.digest, sha1, 20);
-        base->hdr.next_event_offset += sizeof(ev) + ev.event_size;
-        log_write(&ev, sizeof(ev));
-        return log_write(event, ev.event_size);
-    }
+    memset(ptr_current, 0, left < EVTLOG_SENTINEL ? left : EVTLOG_SENTINEL);
+}
 
-    return 1;
+/* Takes size bytes written at ptr_current into the log */
+static int log_commit(u32 size)
+{
+    u32 next;
+
+    memcpy(&next, next_offset, sizeof(next));
+    next += size;
+    memcpy(next_offset, &next, sizeof(next));
+
+    ptr_current += size;
+    log_terminate();
+
+    return 0;
+}
+
+int log_event_tpm12(u32 pcr, u32 type, const u8 *sha1, struct event_str ev)
+{
+    u32 size = sizeof(tpm12_event_t) + ev.len;
+    u8 *p = ptr_current;
+
+    if ( !HAS_ENOUGH_SPACE(size) )
+        return 1;
+
+    p = put(p, &pcr, sizeof(pcr));
+    p = put(p, &type, sizeof(type));
+    p = put(p, sha1, 20);
+    p = put(p, &ev.len, sizeof(ev.len));
+    put(p, ev.str, ev.len);
+
+    return log_commit(size);
 }
 
-int log_event_tpm20(u32 pcr, u8 sha1[20], u8 sha256[32], char *event)
+/*
+ * digests[] has one entry for each bank in the Spec ID event, in the same
+ * order, and the record is written with as many as there are.
+ */
+int log_event_tpm20(u32 pcr, u32 type, const u8 *const digests[],
+                    struct event_str ev)
 {
-    tpm20_event_t ev;
-    tpm20_spec_id_ev_t *base = (tpm20_spec_id_ev_t *)
-                                (evtlog_base + sizeof(tpm12_event_t));
+    const tpm20_digest_sizes_t *banks = &tpm20_id_struct.sizes;
+    u32 size = tpm20_record_size + ev.len;
+    u8 *p = ptr_current;
+    unsigned int i;
 
-    ev.event_size = strlen(event);
+    if ( !HAS_ENOUGH_SPACE(size) )
+        return 1;
 
-    if ( HAS_ENOUGH_SPACE(sizeof(ev) + ev.event_size) )
+    p = put(p, &pcr, sizeof(pcr));
+    p = put(p, &type, sizeof(type));
+    p = put(p, &banks->number_of_algorithms, sizeof(u32));
+    for ( i = 0; i < banks->number_of_algorithms; i++ )
     {
-        ev.pcr = pcr;
-        ev.event_type = EV_TYPE_SLAUNCH;
-        ev.digests.count = 2;
-        ev.digests.sha1_id = TPM_ALG_SHA1;
-        memcpy(ev.digests.sha1_hash, sha1, 20);
-        ev.digests.sha256_id = TPM_ALG_SHA256;
-        memcpy(ev.digests.sha256_hash, sha256, 32);
-        base->el.next_record_offset += sizeof(ev) + ev.event_size;
-        log_write(&ev, sizeof(ev));
-        return log_write(event, ev.event_size);
+        p = put(p, &banks->digest_sizes[i].id, sizeof(u16));
+        p = put(p, digests[i], banks->digest_sizes[i].size);
     }
+    p = put(p, &ev.len, sizeof(ev.len));
+    put(p, ev.str, ev.len);
 
-    return 1;
+    return log_commit(size);
 }
 
 int event_log_init(struct tpm *tpm)
 {
     unsigned int min_size;
     struct skl_tag_evtlog *t = next_of_type(&bootloader_data, SKL_TAG_EVENT_LOG);
+    struct skl_tag_evtlog64 *t64 = next_of_type(&bootloader_data,
+                                                SKL_TAG_EVENT_LOG64);
+    u64 address;
+    u32 size;
 
-    if ( t == NULL || next_of_type(t, SKL_TAG_EVENT_LOG) != NULL )
+    /* Exactly one log, with either tag */
+    if ( t != NULL && t64 == NULL && next_of_type(t, SKL_TAG_EVENT_LOG) == NULL )
+    {
+        address = t->address;
+        size = t->size;
+    }
+    else if ( t == NULL && t64 != NULL &&
+              next_of_type(t64, SKL_TAG_EVENT_LOG64) == NULL )
+    {
+        address = t64->address;
+        size = t64->size;
+    }
+    else
+    {
         goto err;
+    }
 
     min_size = sizeof (tpm12_event_t);
 
-    if ( tpm->family == TPM12 )
+    if ( TPM_FAMILY(tpm->family) == TPM12 )
     {
         min_size += sizeof(tpm12_id_struct);
         min_size += 2 * sizeof(tpm12_event_t); /* SKL and kernel hashes */
     }
-    else if ( tpm->family == TPM20 )
+    else if ( TPM_FAMILY(tpm->family) == TPM20 )
     {
         min_size += sizeof(tpm20_id_struct);
         min_size += 2 * sizeof(tpm20_event_t); /* SKL and kernel hashes */
@@ -227,15 +277,14 @@ int event_log_init(struct tpm *tpm)
     }
 
     /* Note that min_size does not include tpmXX_event_t.event[] entries */
-    if ( t->size < min_size )
+    if ( size < min_size )
         goto err;
 
-    ptr_current = evtlog_base = _p(t->address);
-    limit = _p(t->address + t->size);
-
-    /* Check for overflow */
-    if ( ptr_current > limit )
+    /* Fails for a log which wraps, or can't be mapped */
+    ptr_current = map_phys(address, size);
+    if ( ptr_current == NULL )
         goto err;
+    limit = ptr_current + size;
 
     /*
      * Bootloader controls location and size, so it could force SKL to overwrite
@@ -247,40 +296,53 @@ int event_log_init(struct tpm *tpm)
 
     tpm12_id_struct.hdr.container_size =
             tpm20_id_struct.el.allocated_event_container_size =
-            t->size;
-    tpm20_id_struct.el.phys_addr = _u(evtlog_base);
-
-    memset(ptr_current, 0, t->size);
+            size;
+    tpm20_id_struct.el.phys_addr = address;
 
-    /* Write log header */
+    /* Write log header, which the offsets in it already account for */
     {
-        tpm12_event_t ev;
+        tpm12_event_t *ev = (tpm12_event_t *)ptr_current;
+        void *id = ev + 1;
+        unsigned int i;
+
+        memset(ev, 0, sizeof(*ev));
+        ev->event_type = EV_NO_ACTION;
 
-        ev.pcr = 0;
-        ev.event_type = EV_NO_ACTION;
-        memset(ev.digest, 0, 20);
-        if ( tpm->family == TPM12 )
-            ev.event_size = sizeof(tpm12_id_struct);
+        if ( TPM_FAMILY(tpm->family) == TPM12 )
+        {
+            ev->event_size = sizeof(tpm12_id_struct);
+            memcpy(id, &tpm12_id_struct, sizeof(tpm12_id_struct));
+            next_offset = id + offsetof(tpm12_spec_id_ev_t,
+                                          hdr.next_event_offset);
+        }
         else
-            ev.event_size = sizeof(tpm20_id_struct);
+        {
+            ev->event_size = sizeof(tpm20_id_struct);
+            memcpy(id, &tpm20_id_struct, sizeof(tpm20_id_struct));
+            next_offset = id + offsetof(tpm20_spec_id_ev_t,
+                                          el.next_record_offset);
+
+            /* pcr, event_type, digests.count and event_size */
+            tpm20_record_size = 4 * sizeof(u32);
+            for ( i = 0; i < tpm20_id_struct.sizes.number_of_algorithms; i++ )
+                tpm20_record_size += sizeof(u16) +
+                                     tpm20_id_struct.sizes.digest_sizes[i].size;
+        }
 
-        log_write(&ev, sizeof(ev));
+        ptr_current += sizeof(*ev) + ev->event_size;
+        log_terminate();
     }
 
-    if ( tpm->family == TPM12 )
-        log_write(&tpm12_id_struct, sizeof(tpm12_id_struct));
-    else
-        log_write(&tpm20_id_struct, sizeof(tpm20_id_struct));
-
     /* Log what was done by SKINIT */
-    if ( tpm->family == TPM12 )
+    if ( TPM_FAMILY(tpm->family) == TPM12 )
     {
         struct skl_tag_hash *h = next_of_type(&bootloader_data, SKL_TAG_SKL_HASH);
 
         while ( h != NULL )
         {
             if ( h->algo_id == TPM_ALG_SHA1 )
-                return log_event_tpm12(17, h->digest, "SKINIT");
+                return log_event_tpm12(17, EV_TYPE_SLAUNCH, h->digest,
+                                       EVENT_STR("SKINIT"));
 
             h = next_of_type(h, SKL_TAG_SKL_HASH);
         }
@@ -303,7 +365,9 @@ int event_log_init(struct tpm *tpm)
                 sha256 = h->digest;
 
             if ( sha1 != NULL && sha256 != NULL )
-                return log_event_tpm20(17, sha1, sha256, "SKINIT");
+                return log_event_tpm20(17, EV_TYPE_SLAUNCH,
+                                       (const u8 *[]){ sha1, sha256 },
+                                       EVENT_STR("SKINIT"));
 
             h = next_of_type(h, SKL_TAG_SKL_HASH);
         }
@@ -313,7 +377,7 @@ int event_log_init(struct tpm *tpm)
     }
 
 err:
-    /* Make sure that further calls to log_write() will fail */
+    /* Make sure that further calls to log_event_tpmXX() will fail */
     limit = ptr_current;
     return 1;
 }
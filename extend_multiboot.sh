@@ -9,10 +9,19 @@ fi
 KERNEL=$1
 shift
 
-read SKIP SIZE <<< $(readelf "$KERNEL" -S | sed "s/\[ /\[0/" | awk '/PROGBITS/ {printf "0x%s  0x%s\n", $5, $6}')
-SKIP=$(($SKIP))
-SIZE=$(($SIZE))
-
-extend_sha1 "$(extend_sha1)" "`dd if="$KERNEL" bs=1 skip=$SKIP count=$SIZE 2>/dev/null | sha1sum`" "$@"
-extend_sha256 "$(extend_sha256)" "`dd if="$KERNEL" bs=1 skip=$SKIP count=$SIZE 2>/dev/null | sha256sum`" "$@"
+# Contents of the loadable (A flag, not NOBITS) sections, back to back in
+# section header order, as SKL measures them from the ELF sections tag.
+kernel_sections () {
+	readelf -S -W "$KERNEL" | sed "s/\[ /\[0/" |
+		awk '$3 != "NOBITS" && $8 ~ /A/ {printf "0x%s 0x%s\n", $5, $6}' |
+		while read OFF SIZE ; do
+			dd if="$KERNEL" bs=1 skip=$((OFF)) count=$((SIZE)) 2>/dev/null
+		done
+}
 
+# PCR17 is extended in MBI order.  GRUB2 puts the ELF sections tag after the
+# module tags, so the kernel comes last.
+extend_sha1 "$sha1_zeroes" $(sha1_skl) "$@" \
+	`kernel_sections | sha1sum | grep -o "^[a-fA-F0-9]*"`
+extend_sha256 "$sha256_zeroes" $(sha256_skl) "$@" \
+	`kernel_sections | sha256sum | grep -o "^[a-fA-F0-9]*"`
@@ -0,0 +1,63 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __ACPI_H__
+#define __ACPI_H__
+
+#include <types.h>
+
+/* Table signatures compared as little endian u32 */
+#define ACPI_SIG(a, b, c, d)	((a) | ((b) << 8) | ((c) << 16) | ((d) << 24))
+
+#define ACPI_SIG_RSDP		0x2052545020445352ULL	/* "RSD PTR " */
+
+/* RSDP is searched for in the first 1K of EBDA and in the BIOS ROM area */
+#define ACPI_EBDA_PTR		0x40e
+#define ACPI_BIOS_ROM_START	0xe0000
+#define ACPI_BIOS_ROM_END	0x100000
+
+struct acpi_rsdp {
+    u64 signature;
+    u8  checksum;
+    char oem_id[6];
+    u8  revision;
+    u32 rsdt_address;
+    /* Fields below are present only for revision >= 2 */
+    u32 length;
+    u64 xsdt_address;
+    u8  extended_checksum;
+    u8  reserved[3];
+} __packed;
+
+struct acpi_table_header {
+    u32 signature;
+    u32 length;
+    u8  revision;
+    u8  checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    u32 oem_revision;
+    u32 asl_compiler_id;
+    u32 asl_compiler_revision;
+} __packed;
+
+/*
+ * A checksummed table below 4G, and its length as checked.  Only use that
+ * length, not the one in the table, which a device may change meanwhile.
+ */
+void *acpi_find_table(u32 signature, u32 *length);
+
+#endif /* __ACPI_H__ */
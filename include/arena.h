@@ -0,0 +1,50 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <types.h>
+
+/*
+ * Scratch memory for buffers which are only needed for one phase of the
+ * launch, e.g. the TIS command buffer or a hash context, rather than a
+ * static buffer each.  It is the L2 tables head.S didn't need when it could
+ * map with 1G pages, or else the gap link.lds leaves below .page_data, which
+ * is at least ARENA_MIN.  The SLB's tail is always left to the tags.
+ *
+ * Allocations are freed in reverse order: arena_free(p) frees p and anything
+ * allocated after it, so a phase ends by freeing its first allocation.
+ */
+#define ARENA_ALIGN     64
+
+/*
+ * The TIS command buffer and an ELF section hash context, which may be
+ * allocated at once.  Hardcoded in link.lds, which isn't preprocessed.
+ */
+#define ARENA_MIN       0x100
+
+/* Only once map_gigabytes() has said which L2 tables are unused. */
+void arena_init(void);
+
+/* Never fails, SKL reboots instead.  Not zeroed. */
+void *arena_alloc(u32 size);
+void arena_free(void *p);
+
+/* What could still be allocated, for callers which can make do with less */
+u32 arena_avail(void);
+
+#endif /* __ARENA_H__ */
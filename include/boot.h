@@ -41,6 +41,9 @@
 
 extern const char _start[];
 extern volatile u32 skl_stack_canary;
+#ifdef CONFIG_SIMD
+extern u32 simd_state;
+#endif
 
 typedef struct __packed sl_header {
     u16 skl_entry_point;
@@ -76,6 +79,45 @@ typedef struct __packed ev_log_hash {
 #define smp_wmb()   barrier()
 #define smp_mb()    mb()
 
+/*
+ * One read of memory a device may change under us, e.g. firmware tables
+ * before the IOMMUs are set up, which is then checked and used as is.
+ */
+#define READ_ONCE(x) (*(const volatile typeof(x) *)&(x))
+
+#if __STDC_HOSTED__
+/*
+ * Unit tests run on the host, where there is no hardware to talk to.  Anything
+ * touching it is provided by the test instead, see test-platform.h.
+ */
+u8 ioread8(void *addr);
+u16 ioread16(void *addr);
+u32 ioread32(void *addr);
+u64 ioread64(void *addr);
+void iowrite8(u8 val, void *addr);
+void iowrite16(u16 val, void *addr);
+void iowrite32(u32 val, void *addr);
+void iowrite64(u64 val, void *addr);
+
+u8 inb(u16 port);
+u16 inw(u16 port);
+u32 inl(u16 port);
+void outb(u8 val, u16 port);
+void outw(u16 val, u16 port);
+void outl(u32 val, u16 port);
+void io_delay(void);
+
+u64 rdmsr(u32 msr);
+unsigned long read_cr3(void);
+void write_cr3(unsigned long val);
+void cpuid(u32 leaf, u32 subleaf, u32 *eax, u32 *ebx, u32 *ecx, u32 *edx);
+u64 rdtsc(void);
+void cpu_relax(void);
+void stgi(void);
+void __attribute__((noreturn)) die(void);
+
+#else /* !__STDC_HOSTED__ */
+
 /* MMIO Functions */
 static inline u8 ioread8(void *addr)
 {
@@ -107,6 +149,16 @@ static inline u32 ioread32(void *addr)
     return val;
 }
 
+static inline u64 ioread64(void *addr)
+{
+    u64 val;
+
+    barrier();
+    val = (*(volatile u64 *)(addr));
+    rmb();
+    return val;
+}
+
 static inline void iowrite8(u8 val, void *addr)
 {
 
@@ -130,6 +182,13 @@ static inline void iowrite32(u32 val, void *addr)
     barrier();
 }
 
+static inline void iowrite64(u64 val, void *addr)
+{
+    wmb();
+    (*(volatile u64 *)(addr)) = val;
+    barrier();
+}
+
 /* Basic port I/O */
 static inline u8 inb(u16 port)
 {
@@ -177,6 +236,48 @@ static inline void io_delay(void)
     asm volatile("outb %%al,%0" : : "dN" (DELAY_PORT));
 }
 
+static inline u64 rdmsr(u32 msr)
+{
+    u32 lo, hi;
+
+    asm volatile("rdmsr" : "=a" (lo), "=d" (hi) : "c" (msr));
+    return ((u64)hi << 32) | lo;
+}
+
+static inline unsigned long read_cr3(void)
+{
+    unsigned long val;
+
+    asm volatile("mov %%cr3, %0" : "=r" (val));
+    return val;
+}
+
+static inline void write_cr3(unsigned long val)
+{
+    asm volatile("mov %0, %%cr3" : : "r" (val) : "memory");
+}
+
+static inline void cpuid(u32 leaf, u32 subleaf,
+                         u32 *eax, u32 *ebx, u32 *ecx, u32 *edx)
+{
+    asm volatile("cpuid"
+                 : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+                 : "a" (leaf), "c" (subleaf));
+}
+
+static inline u64 rdtsc(void)
+{
+    u32 lo, hi;
+
+    asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((u64)hi << 32) | lo;
+}
+
+static inline void cpu_relax(void)
+{
+    asm volatile("pause" ::: "memory");
+}
+
 static inline void stgi(void)
 {
     asm volatile(".byte 0x0f, 0x01, 0xdc" ::: "memory");
@@ -188,4 +289,6 @@ static inline void __attribute__((noreturn)) die(void)
     unreachable();
 }
 
+#endif /* __STDC_HOSTED__ */
+
 #endif /* __BOOT_H__ */
@@ -101,6 +101,18 @@
 #define CR4_VMXE  0x00002000/* enable VMX */
 #define CR4_SMXE  0x00004000/* enable SMX */
 #define CR4_PCIDE 0x00020000/* enable PCID */
+#define CR4_OSXSAVE 0x00040000 /* enable XSAVE and XSETBV */
+
+/* XCR0 state components */
+#define XCR0_X87  0x00000001
+#define XCR0_SSE  0x00000002
+#define XCR0_AVX  0x00000004
+
+#define MXCSR_DEFAULT 0x1f80 /* All exceptions masked, round to nearest */
+
+/* What head.S enabled for skl_main(), in simd_state */
+#define SIMD_SSE  0x00000001
+#define SIMD_AVX  0x00000002
 
 /* Pagetable bits */
 #define _PAGE_PRESENT  0x001
@@ -109,12 +121,33 @@
 #define _PAGE_PSE      0x080
 #define L1_PT_SHIFT    12 /* 4Kb */
 #define L2_PT_SHIFT    21 /* 2Mb */
+#define L3_PT_SHIFT    30 /* 1Gb */
+
+/* CPUID leaves and feature bits */
+#define CPUID_MAX_STD_LEAF     0x00000000
+#define CPUID_STD_FEATURES     0x00000001
+#define CPUID_1_ECX_XSAVE      (1 << 26) /* XSAVE, XSETBV and XCR0 */
+#define CPUID_1_ECX_AVX        (1 << 28)
+#define CPUID_STD_FEATURES7    0x00000007
+#define CPUID_7_EBX_ERMS       (1 << 9)  /* Enhanced rep movsb/stosb */
+#define CPUID_7_EDX_FSRM       (1 << 4)  /* Fast short rep movsb */
+#define CPUID_EXT_FEATURES     0x80000001
+#define CPUID_EXT_EDX_PAGE1GB  (1 << 26) /* 1G pages */
 
 /* MSRs */
 
 #define IA32_EFER     0xc0000080
 #define IA32_VM_CR    0xc0010114
 #define IA32_DEBUGCTL 0x000001d9
+#define IA32_MTRR_CAP          0x000000fe
+#define IA32_MTRR_PHYSBASE(n)  (0x00000200 + 2 * (n))
+#define IA32_MTRR_PHYSMASK(n)  (0x00000201 + 2 * (n))
+#define IA32_MTRR_DEF_TYPE     0x000002ff
+
+/* MTRR MSR bits */
+#define MTRR_CAP_VCNT          0xff      /* Variable ranges */
+#define MTRR_DEF_TYPE_E        (1 << 11) /* MTRRs enabled, else all UC */
+#define MTRR_PHYSMASK_VALID    (1 << 11)
 
 /* EFER bits */
 #define EFER_SCE  (1 <<  0) /* SYSCALL/SYSRET */
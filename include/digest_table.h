@@ -0,0 +1,38 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef __DIGEST_TABLE_H__
+#define __DIGEST_TABLE_H__
+
+#include <types.h>
+
+/*
+ * The table asked for with SKL_TAG_DIGEST_TABLE, see tags.h.  Returns
+ * non-zero if the tag is bad.  Without the tag, the calls below do nothing.
+ */
+int digest_table_init(void);
+
+void digest_table_add(const void *data, u64 size, u8 pcr, u16 algo_id,
+                      const u8 *digest, u32 digest_size);
+
+/*
+ * Completes the table, after which nothing more is added to it, and returns
+ * it for measuring.  NULL if there is no table.
+ */
+void *digest_table_finish(u32 *size);
+
+#endif /* __DIGEST_TABLE_H__ */
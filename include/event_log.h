@@ -17,9 +17,30 @@
 #ifndef __EVENT_LOG_H__
 #define __EVENT_LOG_H__
 
+/*
+ * Event types.  EV_NO_ACTION events are logged, but never extended, and have
+ * all zero digests.  EV_TYPE_SLAUNCH_AGGREGATED events are never extended
+ * either, their digests go into the composite of their PCR instead, see
+ * SKL_MEASURE_AGGREGATE.
+ */
+#define EV_NO_ACTION    0x3
+#define EV_TYPE_SLAUNCH 0x502
+#define EV_TYPE_SLAUNCH_MERKLE 0x503   /* See merkle.h */
+#define EV_TYPE_SLAUNCH_AGGREGATED 0x504
+
+/* Event data, with its length worked out by the caller */
+struct event_str {
+    const char *str;
+    u32 len;
+};
+
+/* For string literals only, the length is taken at compile time */
+#define EVENT_STR(s)    ((struct event_str){ s, sizeof(s "") - 1 })
+
 int event_log_init(struct tpm *tpm);
 
-int log_event_tpm12(u32 pcr, u8 sha1[20], char *event);
-int log_event_tpm20(u32 pcr, u8 sha1[20], u8 sha256[32], char *event);
+int log_event_tpm12(u32 pcr, u32 type, const u8 *sha1, struct event_str ev);
+int log_event_tpm20(u32 pcr, u32 type, const u8 *const digests[],
+                    struct event_str ev);
 
 #endif /* __EVENT_LOG_H__ */
@@ -21,6 +21,29 @@
 #define IOMMU_PCI_DEVICE		0x0
 #define IOMMU_PCI_FUNCTION		0x2
 
+/* Upper bound on IOMMUs programmed, one per root complex is typical */
+#define IOMMU_MAX_UNITS			8
+
+/* ACPI IVRS, IVHD blocks start after the header, IVinfo and reserved fields */
+#define ACPI_SIG_IVRS			ACPI_SIG('I', 'V', 'R', 'S')
+#define IVRS_IVDB_OFFSET		0x30
+
+#define IVRS_TYPE_IVHD_10		0x10
+#define IVRS_TYPE_IVHD_11		0x11
+#define IVRS_TYPE_IVHD_40		0x40
+
+struct ivrs_ivhd {
+    u8 type;
+    u8 flags;
+    u16 length;
+    u16 device_id;
+    u16 capability_offset;
+    u64 iommu_base_address;
+    u16 pci_segment;
+    u16 iommu_info;
+    u32 feature_reporting;
+} __packed;
+
 /* fields of Device Table entry (incomplete list) */
 #define IOMMU_DTE_Q0_V			(1ULL << 0)
 #define IOMMU_DTE_Q0_TV			(1ULL << 1)
@@ -35,6 +58,9 @@
 #define IOMMU_DTE_Q2_EINTPASS		(1ULL << (185 - 128))
 #define IOMMU_DTE_Q2_NMIPASS		(1ULL << (186 - 128))
 
+#define IOMMU_CAP_TYPE(h)		(((h) >> 16) & 0x7)
+#define IOMMU_CAP_TYPE_IOMMU		0x3
+
 #define IOMMU_CAP_BA_LOW(c)		(c + 4)
 #define IOMMU_CAP_BA_LOW_ENABLE		(1ULL << 0)
 
@@ -104,6 +130,12 @@
 
 #define IOMMU_EF_IASup			(1ULL << 6)
 
+/*
+ * The TSC frequency isn't known this early, 2^32 ticks is between 1 and 4
+ * seconds on every SKINIT capable CPU, far longer than any flush should take.
+ */
+#define IOMMU_FLUSH_TIMEOUT		(1ULL << 32)
+
 #define COMPLETION_WAIT			1
 #define INVALIDATE_DEVTAB_ENTRY		2
 #define INVALIDATE_IOMMU_PAGES		3
@@ -129,12 +161,16 @@ typedef struct __packed {
     u32 u3;
 } iommu_command_t;
 
-extern char event_log[PAGE_SIZE];
-extern iommu_command_t command_buf[2];
+extern iommu_command_t command_buf[IOMMU_MAX_UNITS][2];
+extern u64 iommu_flush_latency;
 
 void disable_memory_protection(void);
 
 u32 iommu_locate(void);
-u32 iommu_load_device_table(u32 cap, volatile u64 *completed);
+u32 iommu_load_device_table(void);
+void iommu_fail_safe(void);
+void iommu_flush_submit(void);
+int iommu_flush_poll(void);
+int iommu_flush_wait(void);
 
 #endif /* __IOMMU_H__ */
@@ -3,7 +3,11 @@
 #define _LINUX_BOOTPARAMS_H
 
 struct boot_params {
-    u8 _pad0[0x0d8];
+    u8 _pad0[0x0c0];
+    u32 ext_ramdisk_image;
+    u32 ext_ramdisk_size;
+    u32 ext_cmd_line_ptr;
+    u8 _pad1[0x00c];
     u32 tb_dev_map;
     u8 _pad2[0x118];
     u32 syssize;
@@ -11,7 +15,9 @@ struct boot_params {
     u16 version;
     u8 _pad4[0x00c];
     u32 code32_start;
-    u8 _pad6[0x010];
+    u32 ramdisk_image;
+    u32 ramdisk_size;
+    u8 _pad6[0x008];
     u32 cmd_line_ptr;
     u8 _pad8[0x00c];
     u32 cmdline_size;
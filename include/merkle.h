@@ -0,0 +1,98 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __MERKLE_H__
+#define __MERKLE_H__
+
+#include <types.h>
+#include <sha1sum.h>
+#include <sha256.h>
+
+/*
+ * An object measured as a Merkle tree, with SKL_MEASURE_MERKLE, is split
+ * into chunks of 1 << MERKLE_CHUNK_SHIFT bytes, the last one maybe shorter.
+ * An empty object is one empty chunk.  Per bank, with that bank's hash H:
+ *
+ *   leaf i     = H(chunk i)
+ *   node       = H(0x01 || left || right)
+ *   digest     = H(0x02 || struct skl_merkle_event || root)
+ *
+ * The tree is shaped as in RFC 6962: for n > 1 leaves, the left subtree
+ * holds the largest power of two less than n of them.  The digest is what
+ * is logged and extended, with EV_TYPE_SLAUNCH_MERKLE and the event data
+ * starting with the struct skl_merkle_event it covers, so the size and
+ * chunk size can't be changed without changing the digest.
+ */
+#define MERKLE_CHUNK_SHIFT      21
+#define MERKLE_CHUNK_SIZE       (1ULL << MERKLE_CHUNK_SHIFT)
+
+#define MERKLE_NODE             0x01
+#define MERKLE_ROOT             0x02
+
+#define SKL_MERKLE_MAGIC        0x544d4b53  /* "SKMT" */
+#define SKL_MERKLE_VERSION      1
+
+/* Followed in the event data by the object's label, as for other events */
+struct skl_merkle_event {
+    u32 magic;
+    u8 version;
+    u8 chunk_shift;
+    u16 reserved;
+    u64 size;                   /* Of the object, in bytes */
+} __packed;
+
+struct merkle_node {
+    u8 sha1[SHA1_DIGEST_SIZE];
+    u8 sha256[SHA256_DIGEST_SIZE];
+};
+
+/*
+ * Subtrees still waiting for a sibling, one for each bit set in leaves,
+ * so no more than there are bits in the number of chunks.
+ */
+struct merkle {
+    u64 leaves;
+    unsigned int top;
+    bool sha256;
+    struct merkle_node *nodes;
+};
+
+/* Only builds with MERKLE=y measure anything as a tree */
+#ifdef CONFIG_MERKLE
+#define merkle_enabled()        true
+#else
+#define merkle_enabled()        false
+#endif
+
+static inline u64 merkle_chunks(u64 size)
+{
+    return size ? ((size - 1) >> MERKLE_CHUNK_SHIFT) + 1 : 1;
+}
+
+/* What merkle_init() takes from the arena, so callers can check first */
+u32 merkle_arena_size(u64 size);
+
+/* For an object of size bytes, nodes from the arena.  SHA256 only if sha256. */
+void merkle_init(struct merkle *t, u64 size, bool sha256);
+
+/* Adds the next chunk's digests, in order */
+void merkle_add(struct merkle *t, const u8 *sha1, const u8 *sha256);
+
+/* Writes the digests of the object described by ev, and frees t's nodes */
+void merkle_finish(struct merkle *t, const struct skl_merkle_event *ev,
+                   u8 *sha1, u8 *sha256);
+
+#endif /* __MERKLE_H__ */
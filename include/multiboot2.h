@@ -60,12 +60,24 @@ struct multiboot_tag_module
 typedef struct {
     u32 pad0[1];
     u32 sh_type;
-    u32 pad1[2];
+    u32 sh_flags;
+    u32 sh_addr;
     u32 sh_offset;
     u32 sh_size;
     u32 pad2[4];
 } Elf32_Shdr;
 
+/* What 64bit kernels, e.g. Xen, have in the ELF sections tag */
+typedef struct {
+    u32 pad0[1];
+    u32 sh_type;
+    u64 sh_flags;
+    u64 sh_addr;
+    u64 sh_offset;
+    u64 sh_size;
+    u32 pad2[6];
+} Elf64_Shdr;
+
 enum ShT_Types {
     SHT_NULL      = 0,   /* Null section */
     SHT_PROGBITS  = 1,   /* Program information */
@@ -81,6 +93,8 @@ enum ShT_Types {
     SHT_DYNSYM    = 11   /* Dynamic loader symbol table */
 };
 
+#define SHF_ALLOC     (1U << 1)  /* Occupies memory at run time */
+
 struct multiboot_tag_elf_sections
 {
     u32 type;
@@ -0,0 +1,44 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __PAGING_H__
+#define __PAGING_H__
+
+#include <defs.h>
+#include <types.h>
+
+/*
+ * Only the first 4G are mapped by head.S.  Up to 512G can be mapped on
+ * demand, with 1G pages, in the 64bit build on CPUs which have them.
+ */
+#define MAP_PHYS_LIMIT  (512ULL << L3_PT_SHIFT)
+
+/*
+ * Switches each of the second to fourth GB to a 1G page, in the 64bit build
+ * on CPUs which have them, if the MTRRs give it one memory type throughout.
+ * The first GB keeps its 2M pages, and the 4K ones for the first 2M, for the
+ * fixed MTRRs and legacy ranges down there.
+ */
+void map_gigabytes(void);
+
+/*
+ * Makes [addr, addr + size) accessible, and returns a pointer to it.  NULL
+ * if it can't be.  Nothing is unmapped again, the kernel brings its own page
+ * tables.
+ */
+void *map_phys(u64 addr, u64 size);
+
+#endif /* __PAGING_H__ */
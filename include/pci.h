@@ -25,6 +25,7 @@
 #define PCI_CONFIG_ADDR_PORT    (0x0cf8)
 #define PCI_CONFIG_DATA_PORT    (0x0cfc)
 
+#define PCI_VENDOR_ID           0x00    /* 16 bits */
 #define PCI_CAPABILITY_LIST     0x34    /* Offset of first capability list entry */
 
 /* PCI capability ID for IOMMU and SVM DEV - AMD Manual */
@@ -52,6 +53,30 @@
 
 /* From arch/x86/pci/direct.c definitions */
 
+/*
+ * A build for one kind of platform (PCI=conf1 or PCI=ecam to make) calls that
+ * access method directly, rather than the one pci_init() picked.
+ */
+#if defined(CONFIG_PCI_CONF1)
+
+int pci_conf1_read(unsigned int seg, unsigned int bus,
+                   unsigned int devfn, int reg, int len, u32 *value);
+int pci_conf1_write(unsigned int seg, unsigned int bus,
+                    unsigned int devfn, int reg, int len, u32 value);
+#define pci_read    pci_conf1_read
+#define pci_write   pci_conf1_write
+
+#elif defined(CONFIG_PCI_ECAM)
+
+int pci_mmio_read(unsigned int seg, unsigned int bus,
+                  unsigned int devfn, int reg, int len, u32 *value);
+int pci_mmio_write(unsigned int seg, unsigned int bus,
+                   unsigned int devfn, int reg, int len, u32 value);
+#define pci_read    pci_mmio_read
+#define pci_write   pci_mmio_write
+
+#else
+
 extern int (*pci_read)(unsigned int seg, unsigned int bus,
                        unsigned int devfn, int reg, int len, u32 *value);
 
@@ -59,6 +84,8 @@ extern int (*pci_read)(unsigned int seg, unsigned int bus,
 extern int (*pci_write)(unsigned int seg, unsigned int bus,
                         unsigned int devfn, int reg, int len, u32 value);
 
+#endif
+
 u32 pci_locate(unsigned int bus, unsigned int devfn);
 
 void pci_init(void);
@@ -20,8 +20,25 @@
 #ifndef __SHA1SUM_H__
 #define __SHA1SUM_H__
 
+#include <types.h>
+
 #define SHA1_DIGEST_SIZE 20
 
-void sha1sum(u8 hash[static SHA1_DIGEST_SIZE], const void *ptr, u32 len);
+typedef struct {
+    u64 count;
+    union {
+        struct {
+            u32 h0, h1, h2, h3, h4;
+        };
+        u32 h[5];
+    };
+    unsigned char buf[64];
+} SHA1_CONTEXT;
+
+/* For data which isn't in one piece; sha1sum() is all three in one go. */
+void sha1_init(SHA1_CONTEXT *hd);
+void sha1_update(SHA1_CONTEXT *hd, const void *data, u64 len);
+void sha1_final(SHA1_CONTEXT *hd, u8 hash[SHA1_DIGEST_SIZE]);
+void sha1sum(u8 hash[static SHA1_DIGEST_SIZE], const void *ptr, u64 len);
 
 #endif /* __SHA1SUM_H__ */
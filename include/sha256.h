@@ -13,7 +13,18 @@
 #include <types.h>
 
 #define SHA256_DIGEST_SIZE	32
+#define SHA256_BLOCK_SIZE	64
 
-void sha256sum(u8 hash[static SHA256_DIGEST_SIZE], const void *ptr, u32 len);
+struct sha256_state {
+    u32 state[SHA256_DIGEST_SIZE / 4];
+    u64 count;
+    u8 buf[SHA256_BLOCK_SIZE];
+};
+
+/* For data which isn't in one piece; sha256sum() is all three in one go. */
+void sha256_init(struct sha256_state *sctx);
+void sha256_update(struct sha256_state *sctx, const void *data, u64 len);
+void sha256_final(struct sha256_state *sctx, void *_dst);
+void sha256sum(u8 hash[static SHA256_DIGEST_SIZE], const void *ptr, u64 len);
 
 #endif /* SHA256_H */
@@ -3,7 +3,8 @@
 
 #if __STDC_HOSTED__
 
-#include <string.h>	/* memcpy, memset */
+/* Skip over this file, which shadows the libc one on the include path */
+#include_next <string.h>	/* memcpy, memset */
 
 #else
 
@@ -12,6 +12,8 @@ struct setup_indirect {
     u64 addr;
 } __packed;
 
+#define SETUP_INDIRECT           (1U << 31)
+
 /* extensible setup data list node */
 struct setup_data {
     u64 next;
@@ -26,6 +28,7 @@ struct setup_data {
 #define SKL_TAG_NO_CLASS         0x00
 #define SKL_TAG_END              0x00
 #define SKL_TAG_SETUP_INDIRECT   0x01
+#define SKL_TAG_ACPI_RSDP        0x03
 #define SKL_TAG_TAGS_SIZE        0x0F    /* Always first */
 
 /* Tags specifying kernel type */
@@ -33,11 +36,15 @@ struct setup_data {
 #define SKL_TAG_BOOT_LINUX       0x10
 #define SKL_TAG_BOOT_MB2         0x11
 #define SKL_TAG_BOOT_SIMPLE      0x12
+#define SKL_TAG_BOOT_SIMPLE64    0x13
 
 /* Tags specific to TPM event log */
 #define SKL_TAG_EVENT_LOG_CLASS  0x20
 #define SKL_TAG_EVENT_LOG        0x20
 #define SKL_TAG_SKL_HASH         0x21
+#define SKL_TAG_MEASURE_POLICY   0x22
+#define SKL_TAG_EVENT_LOG64      0x23
+#define SKL_TAG_DIGEST_TABLE     0x24
 
 struct skl_tag_hdr {
     u8 type;
@@ -49,6 +56,13 @@ struct skl_tag_tags_size {
     u16 size;
 } __packed;
 
+/*
+ * The tags go from bootloader_data to the end of the SLB.  How much room that
+ * is depends on how SKL was built, bootloaders may rely on this much in any
+ * build; link.lds checks it.
+ */
+#define SKL_TAGS_SIZE_MIN        0x2000
+
 struct skl_tag_boot_linux {
     struct skl_tag_hdr hdr;
     u32 zero_page;
@@ -69,21 +83,126 @@ struct skl_tag_boot_simple_payload {
     u32 arg;
 } __packed;
 
+/*
+ * As SKL_TAG_BOOT_SIMPLE, for a payload which may be anywhere in memory.  The
+ * payload is still entered in 32bit protected mode, so entry and arg are
+ * still 32bit.
+ */
+struct skl_tag_boot_simple_payload64 {
+    struct skl_tag_hdr hdr;
+    u64 base;
+    u64 size;
+    u32 entry;
+    u32 arg;
+} __packed;
+
 struct skl_tag_evtlog {
     struct skl_tag_hdr hdr;
     u32 address;
     u32 size;
 } __packed;
 
+/* As SKL_TAG_EVENT_LOG, for a log above 4G.  Only one of the two is allowed. */
+struct skl_tag_evtlog64 {
+    struct skl_tag_hdr hdr;
+    u64 address;
+    u32 size;
+} __packed;
+
 struct skl_tag_hash {
     struct skl_tag_hdr hdr;
     u16 algo_id;
     u8 digest[];
 } __packed;
 
+/*
+ * Extend each PCR once, with a composite of everything measured into it,
+ * rather than once per object.  The objects are still logged, with their
+ * digests, as EV_TYPE_SLAUNCH_AGGREGATED events which are never extended, and
+ * the composite after them as an EV_TYPE_SLAUNCH one.  The composite is what
+ * the PCR would hold if it started from zero and had every object extended
+ * into it in turn, so verifiers can recompute it from the log.
+ */
+#define SKL_MEASURE_AGGREGATE    (1 << 0)
+
+/*
+ * Measure a SKL_TAG_BOOT_SIMPLE or SKL_TAG_BOOT_SIMPLE64 payload, and each
+ * Multiboot2 module, as a Merkle tree of fixed size chunks rather than as one
+ * stream, see merkle.h.  The chunks can be hashed in any order, and in
+ * parallel, and a verifier can check an object a chunk at a time.  Builds
+ * without MERKLE=y ignore the flag, as do others for objects whose tree
+ * doesn't fit in SKL's scratch memory, see arena.h.
+ */
+#define SKL_MEASURE_MERKLE       (1 << 1)
+
+struct skl_tag_measure_policy {
+    struct skl_tag_hdr hdr;
+    u32 flags;
+} __packed;
+
+/*
+ * A region for SKL to measure in place, e.g. a device tree or firmware image
+ * the kernel will later find through setup_data.  data.type is SETUP_INDIRECT
+ * and data.indirect describes the region, which may be anywhere map_phys()
+ * can reach.  There can be any number of these, they are measured in order
+ * after the kernel.
+ */
 struct skl_tag_setup_indirect {
     struct skl_tag_hdr hdr;
     struct setup_data data;
+    u8 pcr;                     /* 17 or 18 */
+    char label[];               /* For the event log, NUL terminated */
+} __packed;
+
+/*
+ * A region for SKL to fill in with the digests it computed, as a struct
+ * skl_digest_table, so that later stages can use them instead of hashing
+ * the same memory again.  The bootloader can make it the payload of a
+ * setup_data node for Linux, or a module for Multiboot2.  It must not be in
+ * anything which is measured.
+ *
+ * There is an entry per bank for each region measured in one piece.  A
+ * Multiboot2 kernel measured by its ELF sections isn't in one piece, so it
+ * has none, and neither has anything measured as a Merkle tree.  Once
+ * everything else is measured, SKL measures the table itself into PCR18.  A
+ * consumer who trusts that measurement can then trust the digests in the
+ * table.
+ */
+struct skl_tag_digest_table {
+    struct skl_tag_hdr hdr;
+    u64 address;
+    u32 size;
+} __packed;
+
+#define SKL_DIGEST_TABLE_MAGIC      0x54444b53  /* "SKDT" */
+#define SKL_DIGEST_TABLE_VERSION    1
+#define SKL_DIGEST_TABLE_TRUNCATED  (1 << 0)    /* Some digests didn't fit */
+
+struct skl_digest_entry {
+    u64 address;
+    u64 length;
+    u16 algo_id;                /* TPM_ALG_*, as in the event log */
+    u8 pcr;
+    u8 reserved[5];
+    u8 digest[32];              /* SHA1 only uses the first 20 bytes */
+} __packed;
+
+struct skl_digest_table {
+    u32 magic;
+    u8 version;
+    u8 flags;
+    u16 count;
+    struct skl_digest_entry entries[];
+} __packed;
+
+/*
+ * Where the ACPI RSDP is, for firmware which doesn't put it anywhere SKL
+ * would find it by itself, as UEFI doesn't.  It must be below 4G.  SKL then
+ * uses that one, and doesn't look anywhere else.
+ */
+struct skl_tag_acpi_rsdp {
+    struct skl_tag_hdr hdr;
+    u64 address;
 } __packed;
 
 extern struct skl_tag_tags_size bootloader_data;
@@ -93,34 +212,19 @@ static inline void *end_of_tags(void)
     return (((void *) &bootloader_data) + bootloader_data.size);
 }
 
-static inline void *next_tag(void* t)
-{
-    void *x = t + ((struct skl_tag_hdr*)t)->len;
-    return x < end_of_tags() ? x : NULL;
-}
+/*
+ * Checks the tags in bootloader_data and indexes them, in one pass.  Only
+ * SKL_MAX_TAGS tags of types below SKL_TAG_INDEX_TYPES are allowed, others
+ * are skipped over.  Returns 0 if the tags are fine, which the lookups below
+ * rely on.
+ */
+#define SKL_TAG_INDEX_TYPES      0x30
+#define SKL_MAX_TAGS             64
 
-static inline void *next_of_type(void* _t, u8 type)
-{
-    struct skl_tag_hdr *t = _t;
-    while ( t->type != SKL_TAG_END )
-    {
-        t = next_tag(t);
-        if ( t->type == type )
-            return (void*)t < end_of_tags() ? t : NULL;
-    }
-    return NULL;
-}
+int tags_index(void);
 
-static inline void *next_of_class(void* _t, u8 c)
-{
-    struct skl_tag_hdr *t = _t;
-    while ( t->type != SKL_TAG_END )
-    {
-        t = next_tag(t);
-        if ( (t->type & SKL_TAG_CLASS_MASK) == c )
-            return (void*)t < end_of_tags() ? t : NULL;
-    }
-    return NULL;
-}
+/* The first tag of the given type or class after t, NULL if there isn't one */
+void *next_of_type(void *t, u8 type);
+void *next_of_class(void *t, u8 c);
 
 #endif /* __TAGS_H__ */
@@ -28,6 +28,7 @@
  * compatible with the rest of the environment.
  */
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef  uint8_t  u8;
 typedef uint16_t u16;
@@ -59,6 +60,8 @@ typedef unsigned long       size_t;
 typedef long                ssize_t;
 
 typedef _Bool               bool;
+#define true  1
+#define false 0
 
 #define NULL ((void *)0)
 
@@ -17,7 +17,9 @@
 #include <defs.h>
 #include <boot.h>
 #include <types.h>
+#include <errno-base.h>
 #include <pci.h>
+#include <acpi.h>
 #include <iommu.h>
 #include <printk.h>
 
@@ -26,60 +28,187 @@ iommu_dte_t device_table[2 * PAGE_SIZE / sizeof(iommu_dte_t)] __page_data = {
         .a = IOMMU_DTE_Q0_V + IOMMU_DTE_Q0_TV,
     },
 };
-iommu_command_t command_buf[2] __aligned(sizeof(iommu_command_t));
-char event_log[PAGE_SIZE] __page_data;
+/* Two commands per IOMMU, see iommu_load_device_table() for details. */
+iommu_command_t command_buf[IOMMU_MAX_UNITS][2] __aligned(sizeof(iommu_command_t));
 
+struct iommu {
+    u64 *mmio_base;
+    u8 bus, devfn, cap;
+    u8 cmd_idx;
+    bool enabled;
+};
+
+static struct iommu iommus[IOMMU_MAX_UNITS];
+static unsigned int nr_iommus;
+
+/* Targets of COMPLETION_WAIT stores, one per IOMMU, must be 8 byte aligned. */
+static volatile u64 flush_done[IOMMU_MAX_UNITS] __aligned(8);
+
+static enum {
+    FLUSH_IDLE,
+    FLUSH_PENDING,
+    FLUSH_DONE,
+    FLUSH_TIMED_OUT,
+} flush_state;
+static u64 flush_start, flush_deadline;
+
+/* TSC ticks between iommu_flush_submit() and completion being observed. */
+u64 iommu_flush_latency;
+
+static u64 mmio_read(u64 *mmio_base, unsigned int reg)
+{
+    return ioread64(&mmio_base[reg]);
+}
+
+static void mmio_write(u64 *mmio_base, unsigned int reg, u64 val)
+{
+    iowrite64(val, &mmio_base[reg]);
+}
+
+static void mmio_set(u64 *mmio_base, unsigned int reg, u64 bits)
+{
+    mmio_write(mmio_base, reg, mmio_read(mmio_base, reg) | bits);
+}
+
+static void mmio_clear(u64 *mmio_base, unsigned int reg, u64 bits)
+{
+    mmio_write(mmio_base, reg, mmio_read(mmio_base, reg) & ~bits);
+}
+
+/*
+ * IVRS isn't measured, so the capability it gives is only used if it is the
+ * one pci_locate() finds in the function's own list, and says it's an
+ * IOMMU's.  load_device_table() programs whatever the BAR words in it point
+ * to, and still checks that firmware enabled them.
+ */
+static void add_iommu(unsigned int bus, unsigned int devfn, u32 cap)
+{
+    unsigned int i;
+    u32 hdr;
+
+    if ( cap == 0 || cap != pci_locate(bus, devfn) )
+        return;
+
+    pci_read(0, bus, devfn, cap, 4, &hdr);
+    if ( IOMMU_CAP_TYPE(hdr) != IOMMU_CAP_TYPE_IOMMU )
+        return;
+
+    for ( i = 0; i < nr_iommus; i++ )
+        if ( iommus[i].bus == bus && iommus[i].devfn == devfn )
+            return;
+
+    if ( nr_iommus == IOMMU_MAX_UNITS )
+    {
+        print("Too many IOMMUs\n");
+        return;
+    }
+
+    iommus[nr_iommus++] = (struct iommu){
+        .bus = bus,
+        .devfn = devfn,
+        .cap = cap,
+    };
+}
+
+/*
+ * Walk IVHD blocks in the ACPI IVRS table.  Each IOMMU may be described by
+ * more than one block (types 10h, 11h and 40h), add_iommu() drops duplicates.
+ */
+static void iommu_parse_ivrs(void)
+{
+    u32 len;
+    struct acpi_table_header *ivrs = acpi_find_table(ACPI_SIG_IVRS, &len);
+    void *p, *end;
+
+    if ( ivrs == NULL )
+    {
+        print("No IVRS, using 00:00.2\n");
+        return;
+    }
+
+    end = _p(ivrs) + len;
+
+    /* Nothing protects IVRS yet, so each length is only read once. */
+    for ( p = _p(ivrs) + IVRS_IVDB_OFFSET;
+          p + sizeof(struct ivrs_ivhd) <= end; p += len )
+    {
+        struct ivrs_ivhd *ivhd = p;
+
+        len = READ_ONCE(ivhd->length);
+        if ( len < sizeof(struct ivrs_ivhd) )
+            break;
+
+        if ( ivhd->type != IVRS_TYPE_IVHD_10 &&
+             ivhd->type != IVRS_TYPE_IVHD_11 &&
+             ivhd->type != IVRS_TYPE_IVHD_40 )
+            continue;
+
+        /* pci_read() only handles segment 0 */
+        if ( ivhd->pci_segment != 0 )
+            continue;
+
+        add_iommu(ivhd->device_id >> 8, ivhd->device_id & 0xff,
+                  ivhd->capability_offset);
+    }
+}
+
+/*
+ * Returns the number of IOMMUs found.  The one at the fixed location is
+ * always probed, so that a missing or truncated IVRS can't leave it out.
+ */
 u32 iommu_locate(void)
 {
-    return pci_locate(IOMMU_PCI_BUS,
-                      PCI_DEVFN(IOMMU_PCI_DEVICE, IOMMU_PCI_FUNCTION));
+    nr_iommus = 0;
+
+    add_iommu(IOMMU_PCI_BUS, PCI_DEVFN(IOMMU_PCI_DEVICE, IOMMU_PCI_FUNCTION),
+              pci_locate(IOMMU_PCI_BUS,
+                         PCI_DEVFN(IOMMU_PCI_DEVICE, IOMMU_PCI_FUNCTION)));
+    iommu_parse_ivrs();
+
+    return nr_iommus;
 }
 
-static void send_command(u64 *mmio_base, iommu_command_t cmd, u32 *idx)
+static u64 cmd_offset(const iommu_command_t *cmd)
 {
-    command_buf[(*idx)++] = cmd;
+    return _u(cmd) - (_u(command_buf) & ~0xfff);
+}
+
+static void send_command(unsigned int unit, iommu_command_t cmd)
+{
+    struct iommu *iommu = &iommus[unit];
+
+    command_buf[unit][iommu->cmd_idx++] = cmd;
     smp_wmb();
-    mmio_base[IOMMU_MMIO_COMMAND_BUF_TAIL] =
-        _u(&command_buf[*idx]) - (_u(&command_buf) & ~0xfff);
+    mmio_write(iommu->mmio_base, IOMMU_MMIO_COMMAND_BUF_TAIL,
+               cmd_offset(&command_buf[unit][iommu->cmd_idx]));
 }
 
-u32 iommu_load_device_table(u32 cap, volatile u64 *completed)
+static u32 load_device_table(unsigned int unit)
 {
+    struct iommu *iommu = &iommus[unit];
     u64 *mmio_base;
-    u32 low, hi, idx = 0;
-    iommu_command_t cmd = {0};
+    u32 low, hi;
 
-    pci_read(0, IOMMU_PCI_BUS,
-             PCI_DEVFN(IOMMU_PCI_DEVICE, IOMMU_PCI_FUNCTION),
-             IOMMU_CAP_BA_LOW(cap),
+    iommu->enabled = false;
+
+    pci_read(0, iommu->bus, iommu->devfn, IOMMU_CAP_BA_LOW(iommu->cap),
              4, &low);
 
     /* IOMMU must be enabled by AGESA */
     if ( (low & IOMMU_CAP_BA_LOW_ENABLE) == 0 )
         return 1;
 
-    pci_read(0, IOMMU_PCI_BUS,
-             PCI_DEVFN(IOMMU_PCI_DEVICE, IOMMU_PCI_FUNCTION),
-             IOMMU_CAP_BA_HIGH(cap),
+    pci_read(0, iommu->bus, iommu->devfn, IOMMU_CAP_BA_HIGH(iommu->cap),
              4, &hi);
 
-    mmio_base = _p((u64)hi << 32 | (low & 0xffffc000));
-
-    print_u64((u64)_u(mmio_base));
-    print("IOMMU MMIO Base Address\n");
-
-    print_u64(mmio_base[IOMMU_MMIO_STATUS_REGISTER]);
-    print("IOMMU_MMIO_STATUS_REGISTER\n");
+    iommu->mmio_base = mmio_base = _p((u64)hi << 32 | (low & 0xffffc000));
 
     /* Disable IOMMU and all its features */
-    mmio_base[IOMMU_MMIO_CONTROL_REGISTER] &= ~IOMMU_CR_ENABLE_ALL_MASK;
+    mmio_clear(mmio_base, IOMMU_MMIO_CONTROL_REGISTER, IOMMU_CR_ENABLE_ALL_MASK);
     smp_wmb();
 
     /* Address and size of Device Table (bits 8:0 = 0 -> 4KB; 1 -> 8KB ...) */
-    mmio_base[IOMMU_MMIO_DEVICE_TABLE_BA] = (u64)_u(device_table) | 1;
-
-    print_u64(mmio_base[IOMMU_MMIO_DEVICE_TABLE_BA]);
-    print("IOMMU_MMIO_DEVICE_TABLE_BA\n");
+    mmio_write(mmio_base, IOMMU_MMIO_DEVICE_TABLE_BA, (u64)_u(device_table) | 1);
 
     /*
      * !!! WARNING - HERE BE DRAGONS !!!
@@ -95,67 +224,283 @@ u32 iommu_load_device_table(u32 cap, volatile u64 *completed)
      * on the size of one entry.  We program the IOMMU to say that the
      * command buffer is 8k long (to cover the case that the array crosses
      * a page boundary), and move both the head and tail pointers forwards
-     * to the start of the buffer.
+     * to the start of the buffer.  Every IOMMU gets its own pair of
+     * entries in the same buffer, so their head and tail pointers never
+     * overlap.
      *
      * This will malfunction if more commands are sent than fit in
      * command_buf[] to begin with, but we do save almost 4k of space,
      * 1/16th of that available to us.
      */
-    mmio_base[IOMMU_MMIO_COMMAND_BUF_BA] = (u64)(_u(command_buf) & ~0xfff)| (0x9ULL << 56);
-    mmio_base[IOMMU_MMIO_COMMAND_BUF_HEAD] =
-        mmio_base[IOMMU_MMIO_COMMAND_BUF_TAIL] = _u(command_buf) & 0xff0;
+    mmio_write(mmio_base, IOMMU_MMIO_COMMAND_BUF_BA,
+               (u64)(_u(command_buf) & ~0xfff) | (0x9ULL << 56));
+    mmio_write(mmio_base, IOMMU_MMIO_COMMAND_BUF_HEAD,
+               cmd_offset(command_buf[unit]));
+    mmio_write(mmio_base, IOMMU_MMIO_COMMAND_BUF_TAIL,
+               cmd_offset(command_buf[unit]));
+    iommu->cmd_idx = 0;
 
-    print_u64(_u(command_buf));
-    print("Command Buffer Base\n");
+    /*
+     * There is no room for an Event Log in the SLB, and nothing in SKL would
+     * read it, so event logging stays disabled.  An error still stops command
+     * processing, and with it the flush, which iommu_flush_poll() times out.
+     */
 
-    print_u64(mmio_base[IOMMU_MMIO_COMMAND_BUF_BA]);
-    print("IOMMU_MMIO_COMMAND_BUF_BA\n");
+    /* Clear EventLogInt set by IOMMU not being able to read command buffer */
+    mmio_clear(mmio_base, IOMMU_MMIO_STATUS_REGISTER, 2);
+    smp_wmb();
+    mmio_set(mmio_base, IOMMU_MMIO_CONTROL_REGISTER, IOMMU_CR_CmdBufEn);
+    smp_wmb();
 
-    print_u64(mmio_base[IOMMU_MMIO_COMMAND_BUF_HEAD]);
-    print("IOMMU_MMIO_COMMAND_BUF_HEAD\n");
+    mmio_set(mmio_base, IOMMU_MMIO_CONTROL_REGISTER, IOMMU_CR_IommuEn);
 
-    /* Address and size of Event Log, reset head and tail registers */
-    mmio_base[IOMMU_MMIO_EVENT_LOG_BA] = (u64)_u(event_log) | (0x8ULL << 56);
-    mmio_base[IOMMU_MMIO_EVENT_LOG_HEAD] = 0;
-    mmio_base[IOMMU_MMIO_EVENT_LOG_TAIL] = 0;
+    iommu->enabled = true;
 
-    print_u64(mmio_base[IOMMU_MMIO_EVENT_LOG_BA]);
-    print("IOMMU_MMIO_EVENT_LOG_BA\n");
+    return 0;
+}
 
-    /* Clear EventLogInt set by IOMMU not being able to read command buffer */
-    mmio_base[IOMMU_MMIO_STATUS_REGISTER] &= ~2;
+/*
+ * Point every located IOMMU at the blocking device_table.  Returns the number
+ * of IOMMUs which couldn't be programmed.
+ */
+u32 iommu_load_device_table(void)
+{
+    unsigned int i;
+    u32 failed = 0;
+
+    for ( i = 0; i < nr_iommus; i++ )
+        failed += load_device_table(i);
+
+    return failed;
+}
+
+static iommu_command_t completion_wait(unsigned int unit)
+{
+    iommu_command_t cmd = {0};
+
+    /* Write to a variable inside SLB (does not work in the first call) */
+    cmd.u0 = _u(&flush_done[unit]) | 1;
+    cmd.u1 = (u64)_u(&flush_done[unit]) >> 32;
+
+    cmd.opcode = COMPLETION_WAIT;
+    cmd.u2 = 0x656e6f64;    /* "done" */
+
+    return cmd;
+}
+
+static void set_command_buf(unsigned int unit, u64 ba, u64 head, u64 tail)
+{
+    u64 *mmio_base = iommus[unit].mmio_base;
+
+    /* Base address can only be changed with the command buffer disabled */
+    mmio_clear(mmio_base, IOMMU_MMIO_CONTROL_REGISTER, IOMMU_CR_CmdBufEn);
+    smp_wmb();
+    mmio_write(mmio_base, IOMMU_MMIO_COMMAND_BUF_BA, ba);
+    mmio_write(mmio_base, IOMMU_MMIO_COMMAND_BUF_HEAD, head);
+    mmio_write(mmio_base, IOMMU_MMIO_COMMAND_BUF_TAIL, head);
     smp_wmb();
-    mmio_base[IOMMU_MMIO_CONTROL_REGISTER] |= IOMMU_CR_CmdBufEn | IOMMU_CR_EventLogEn;
+    mmio_set(mmio_base, IOMMU_MMIO_CONTROL_REGISTER, IOMMU_CR_CmdBufEn);
     smp_wmb();
+    mmio_write(mmio_base, IOMMU_MMIO_COMMAND_BUF_TAIL, tail);
+}
+
+/*
+ * Without IASup there is no single command dropping everything an IOMMU may
+ * have cached, and its DTEs have to be invalidated one by one.  Only the
+ * DeviceIDs device_table[] covers are: the rest are outside DevTabSize, which
+ * the IOMMU rejects as an illegal command, stopping command processing.
+ * That is still more than the two entries in command_buf[] can hold, and
+ * there is no room for a proper ring in the SLB.
+ *
+ * Instead, the INVALIDATE_DEVTAB_ENTRY commands are queued a batch at a time,
+ * with the same trick as command_buf[]: every such IOMMU is pointed at the
+ * batch through an 8k window around it.  INVALIDATE_DEVTAB_ENTRY is the same
+ * for every IOMMU, so they all fetch the same batch, and iommu_flush_poll()
+ * refills it once the slowest of them is done.  After the last batch, each
+ * is pointed back at its command_buf[] entries for its own COMPLETION_WAIT.
+ */
+#define NR_DEVIDS       ARRAY_SIZE(device_table)
 
-    mmio_base[IOMMU_MMIO_CONTROL_REGISTER] |= IOMMU_CR_IommuEn;
+static iommu_command_t batch[8] __aligned(sizeof(iommu_command_t));
+static u32 batch_len;
+static u32 batch_next;              /* Next DeviceID to queue */
+static unsigned int batch_units;    /* Bitmap of IOMMUs using the batch */
 
-    print_u64(mmio_base[IOMMU_MMIO_STATUS_REGISTER]);
-    print("IOMMU_MMIO_STATUS_REGISTER\n");
+static u64 batch_offset(const iommu_command_t *cmd)
+{
+    return _u(cmd) - (_u(batch) & ~0xfff);
+}
+
+/* Point the IOMMU back at its entries in command_buf[], and complete there. */
+static void batch_finish(unsigned int unit)
+{
+    u64 offset = cmd_offset(&command_buf[unit][iommus[unit].cmd_idx]);
 
-    if ( mmio_base[IOMMU_MMIO_EXTENDED_FEATURE] & IOMMU_EF_IASup )
+    set_command_buf(unit, (u64)(_u(command_buf) & ~0xfff) | (0x9ULL << 56),
+                    offset, offset);
+    send_command(unit, completion_wait(unit));
+}
+
+/*
+ * Once every IOMMU has fetched the whole batch, queue the next one, or send
+ * them to batch_finish() if there are no DeviceIDs left.
+ */
+static void batch_poll(void)
+{
+    unsigned int i;
+
+    /* Nothing is queued yet when called from iommu_flush_submit() */
+    if ( batch_len )
+        for ( i = 0; i < nr_iommus; i++ )
+            if ( (batch_units & (1U << i)) &&
+                 mmio_read(iommus[i].mmio_base, IOMMU_MMIO_COMMAND_BUF_HEAD) !=
+                 batch_offset(&batch[batch_len]) )
+                return;
+
+    if ( batch_next == NR_DEVIDS )
     {
-        print("INVALIDATE_IOMMU_ALL\n");
-        cmd.opcode = INVALIDATE_IOMMU_ALL;
-        send_command(mmio_base, cmd, &idx);
-    } /* TODO: else? */
+        for ( i = 0; i < nr_iommus; i++ )
+            if ( batch_units & (1U << i) )
+                batch_finish(i);
 
-    print_u64(mmio_base[IOMMU_MMIO_EXTENDED_FEATURE]);
-    print("IOMMU_MMIO_EXTENDED_FEATURE\n");
-    print_u64(mmio_base[IOMMU_MMIO_STATUS_REGISTER]);
-    print("IOMMU_MMIO_STATUS_REGISTER\n");
+        batch_units = 0;
+        return;
+    }
 
-    /* Write to a variable inside SLB (does not work in the first call) */
-    cmd.u0 = _u(completed) | 1;
-    /* This should be '_u(completed)>>32', but SLB can't be above 4GB anyway */
-    cmd.u1 = 0;
+    for ( batch_len = 0; batch_len < ARRAY_SIZE(batch) &&
+                         batch_next < NR_DEVIDS; batch_len++ )
+    {
+        iommu_command_t cmd = {0};
+
+        cmd.u0 = batch_next++;
+        cmd.opcode = INVALIDATE_DEVTAB_ENTRY;
+        batch[batch_len] = cmd;
+    }
+    smp_wmb();
+
+    for ( i = 0; i < nr_iommus; i++ )
+        if ( batch_units & (1U << i) )
+            set_command_buf(i, (u64)(_u(batch) & ~0xfff) | (0x9ULL << 56),
+                            batch_offset(batch),
+                            batch_offset(&batch[batch_len]));
+}
+
+/*
+ * Have every programmed IOMMU fetch a command while SLB protection is still
+ * on, which it can't, putting it into the fail-safe state.  See iommu_setup()
+ * in main.c.
+ */
+void iommu_fail_safe(void)
+{
+    iommu_command_t cmd = {0};
+    unsigned int i;
 
     cmd.opcode = COMPLETION_WAIT;
-    cmd.u2 = 0x656e6f64;    /* "done" */
-    send_command(mmio_base, cmd, &idx);
 
-    print_u64(mmio_base[IOMMU_MMIO_STATUS_REGISTER]);
-    print("IOMMU_MMIO_STATUS_REGISTER\n");
+    for ( i = 0; i < nr_iommus; i++ )
+        if ( iommus[i].enabled )
+            send_command(i, cmd);
+}
 
-    return 0;
+/*
+ * Queue invalidation of all cached translations, followed by COMPLETION_WAIT
+ * storing to flush_done[], on every programmed IOMMU.  IOMMUs without IASup
+ * share the batches (see above) instead, which iommu_flush_poll() refills.
+ * Doesn't wait for them, use iommu_flush_poll() or iommu_flush_wait() for
+ * that.
+ */
+void iommu_flush_submit(void)
+{
+    unsigned int i;
+
+    batch_units = 0;
+
+    for ( i = 0; i < nr_iommus; i++ )
+    {
+        struct iommu *iommu = &iommus[i];
+        iommu_command_t cmd = {0};
+
+        flush_done[i] = !iommu->enabled;
+        if ( !iommu->enabled )
+            continue;
+
+        if ( !(mmio_read(iommu->mmio_base, IOMMU_MMIO_EXTENDED_FEATURE) &
+               IOMMU_EF_IASup) )
+        {
+            batch_units |= 1U << i;
+            continue;
+        }
+
+        cmd.opcode = INVALIDATE_IOMMU_ALL;
+        send_command(i, cmd);
+        send_command(i, completion_wait(i));
+    }
+
+    if ( batch_units )
+    {
+        batch_len = batch_next = 0;
+        batch_poll();
+    }
+
+    flush_state = FLUSH_PENDING;
+    flush_start = rdtsc();
+    flush_deadline = flush_start + IOMMU_FLUSH_TIMEOUT;
+}
+
+/*
+ * Non-blocking check of the last iommu_flush_submit().  Returns 0 when the
+ * flush has completed on every IOMMU, -EAGAIN while any is still in flight,
+ * -EBUSY if they didn't all complete before the deadline, and -EINVAL if
+ * nothing was submitted.
+ */
+int iommu_flush_poll(void)
+{
+    unsigned int i;
+    u64 now;
+
+    switch ( flush_state )
+    {
+    case FLUSH_IDLE:
+        return -EINVAL;
+    case FLUSH_DONE:
+        return 0;
+    case FLUSH_TIMED_OUT:
+        return -EBUSY;
+    case FLUSH_PENDING:
+        break;
+    }
+
+    now = rdtsc();
+
+    if ( batch_units )
+        batch_poll();
+
+    for ( i = 0; i < nr_iommus; i++ )
+        if ( !flush_done[i] )
+            break;
+
+    if ( i == nr_iommus )
+    {
+        iommu_flush_latency = now - flush_start;
+        flush_state = FLUSH_DONE;
+        return 0;
+    }
+
+    if ( now > flush_deadline )
+    {
+        flush_state = FLUSH_TIMED_OUT;
+        return -EBUSY;
+    }
+
+    return -EAGAIN;
+}
+
+int iommu_flush_wait(void)
+{
+    int ret;
+
+    while ( (ret = iommu_flush_poll()) == -EAGAIN )
+        cpu_relax();
+
+    return ret;
 }
@@ -18,6 +18,7 @@
 
 #include <defs.h>
 #include <types.h>
+#include <errno-base.h>
 #include <boot.h>
 #include <pci.h>
 #include <iommu.h>
@@ -27,11 +28,15 @@
 #include <sha256.h>
 #include <linux-bootparams.h>
 #include <event_log.h>
+#include <digest_table.h>
+#include <merkle.h>
 #include <multiboot2.h>
 #include <tags.h>
 #include <string.h>
 #include <printk.h>
 #include <dev.h>
+#include <paging.h>
+#include <arena.h>
 
 u32 boot_protocol;
 
@@ -45,31 +50,275 @@ skl_info_t __section(".skl_info") __used skl_info = {
     .msb_key_hash = { 0 },
 };
 
-static void extend_pcr(struct tpm *tpm, void *data, u32 size, u32 pcr, char *ev)
+/* SKL_MEASURE_* flags from the bootloader */
+static u32 measure_flags;
+
+/* Composite digests of what was measured into PCR17 and PCR18 so far */
+static struct composite {
+    u32 count;
+    u8 sha1[SHA1_DIGEST_SIZE];
+    u8 sha256[SHA256_DIGEST_SIZE];
+} composite[2];
+
+/*
+ * Even though die() has both __attribute__((noreturn)) and unreachable(),
+ * Clang still complains if it isn't repeated here.
+ */
+static void __attribute__((noreturn)) reboot(void)
+{
+    print("Rebooting now...");
+    die();
+    unreachable();
+}
+
+static void log_digests(struct tpm *tpm, u32 pcr, u32 type, u8 *sha1,
+                        u8 *sha256, struct event_str ev)
+{
+    if ( TPM_FAMILY(tpm->family) == TPM12 )
+        log_event_tpm12(pcr, type, sha1, ev);
+    else if ( TPM_FAMILY(tpm->family) == TPM20 )
+        log_event_tpm20(pcr, type, (const u8 *[]){ sha1, sha256 }, ev);
+}
+
+/* A launch whose log the PCRs don't match is no use to anyone */
+static void extend_digests(struct tpm *tpm, u32 pcr, u8 *sha1, u8 *sha256)
+{
+    if ( tpm_extend_pcr(tpm, pcr, TPM_ALG_SHA1, sha1) ||
+         (TPM_FAMILY(tpm->family) == TPM20 &&
+          tpm_extend_pcr(tpm, pcr, TPM_ALG_SHA256, sha256)) )
+    {
+        print("PCR extend failed\n");
+        reboot();
+    }
+}
+
+/* C := H(C || digest), as the TPM would do it to the PCR */
+static void composite_add(struct tpm *tpm, struct composite *c, u8 *sha1,
+                          u8 *sha256)
+{
+    u8 buf[2 * SHA256_DIGEST_SIZE];
+
+    memcpy(buf, c->sha1, SHA1_DIGEST_SIZE);
+    memcpy(buf + SHA1_DIGEST_SIZE, sha1, SHA1_DIGEST_SIZE);
+    sha1sum(c->sha1, buf, 2 * SHA1_DIGEST_SIZE);
+
+    if ( TPM_FAMILY(tpm->family) == TPM20 )
+    {
+        memcpy(buf, c->sha256, SHA256_DIGEST_SIZE);
+        memcpy(buf + SHA256_DIGEST_SIZE, sha256, SHA256_DIGEST_SIZE);
+        sha256sum(c->sha256, buf, 2 * SHA256_DIGEST_SIZE);
+    }
+
+    c->count++;
+}
+
+/*
+ * Objects are hashed and logged as soon as they are found, but only extended
+ * once the TPM has finished coming up, so that the two overlap.  If there are
+ * more than fit here, the TPM is waited for early.  The SLB has no room for
+ * a longer queue.
+ */
+#define MAX_PENDING 4
+
+static struct pending {
+    u32 pcr;
+    u8 sha1[SHA1_DIGEST_SIZE];
+    u8 sha256[SHA256_DIGEST_SIZE];
+} pending[MAX_PENDING];
+static unsigned int nr_pending;
+
+/* TSC at which TPM bring-up was started, 0 once it has been waited for */
+static u64 tpm_started;
+
+/* Appends s and v, as 16 hex digits, to p.  Returns the new end of string. */
+static char *append_hex(char *p, const char *s, u64 v)
+{
+    int i;
+
+    while ( *s )
+        *p++ = *s++;
+
+    for ( i = 60; i >= 0; i -= 4 )
+        *p++ = "0123456789abcdef"[(v >> i) & 0xf];
+
+    *p = '\0';
+    return p;
+}
+
+/*
+ * Wait for the TPM to be ready for commands, and log how long it had to come
+ * up while we were hashing, and how much longer it took after that.  Where
+ * the interface keeps count, also log how long enable_tpm() and the locality
+ * requests waited on the TPM's other transitions.
+ */
+static void wait_tpm(struct tpm *tpm)
+{
+    u8 zero[SHA256_DIGEST_SIZE] = { 0 };
+    const struct tpm_waits *waits;
+    u64 hashed, ready;
+    char ev[136], *end;
+
+    if ( !tpm_started )
+        return;
+
+    hashed = rdtsc();
+    if ( tpm_wait_ready(tpm) )
+    {
+        print("TPM not ready\n");
+        reboot();
+    }
+    ready = rdtsc();
+
+    end = append_hex(append_hex(ev, "TPM bring-up TSC ticks: overlapped 0x",
+                                hashed - tpm_started),
+                     ", waited 0x", ready - hashed);
+
+    waits = tpm_get_waits(tpm);
+    if ( waits != NULL )
+        end = append_hex(append_hex(end, ", locality 0x", waits->grant),
+                         ", idle 0x", waits->idle);
+    log_digests(tpm, 17, EV_NO_ACTION, zero, zero,
+                (struct event_str){ ev, end - ev });
+
+    tpm_started = 0;
+}
+
+static void flush_pending(struct tpm *tpm)
+{
+    struct pending *m;
+
+    wait_tpm(tpm);
+
+    for ( m = pending; m < pending + nr_pending; m++ )
+        extend_digests(tpm, m->pcr, m->sha1, m->sha256);
+
+    nr_pending = 0;
+}
+
+/* Slot for the next measurement, the TPM is waited for if they're all used */
+static struct pending *next_pending(struct tpm *tpm, u32 pcr)
 {
-    u8 hash[SHA1_DIGEST_SIZE];
-    sha1sum(hash, data, size);
-    print("shasum calculated:\n");
-    hexdump(hash, SHA1_DIGEST_SIZE);
-    tpm_extend_pcr(tpm, pcr, TPM_ALG_SHA1, hash);
+    struct pending *m;
+
+    if ( nr_pending == ARRAY_SIZE(pending) )
+        flush_pending(tpm);
+
+    m = &pending[nr_pending];
+    m->pcr = pcr;
+
+    return m;
+}
 
-    if ( tpm->family == TPM12 )
+/* Logs the digests hashed into m, and queues them unless aggregating */
+static void record_pending(struct tpm *tpm, struct pending *m, u32 type,
+                           struct event_str ev)
+{
+    if ( !(measure_flags & SKL_MEASURE_AGGREGATE) )
     {
-        log_event_tpm12(pcr, hash, ev);
+        log_digests(tpm, m->pcr, type, m->sha1, m->sha256, ev);
+        nr_pending++;
+        return;
     }
-    else if ( tpm->family == TPM20 )
+
+    /* Only logged, extend_composites() does the TPM's part. */
+    composite_add(tpm, &composite[m->pcr - 17], m->sha1, m->sha256);
+    log_digests(tpm, m->pcr, EV_TYPE_SLAUNCH_AGGREGATED, m->sha1, m->sha256,
+                ev);
+}
+
+static void measure(struct tpm *tpm, void *data, u64 size, u32 pcr,
+                    struct event_str ev)
+{
+    struct pending *m = next_pending(tpm, pcr);
+
+    sha1sum(m->sha1, data, size);
+    digest_table_add(data, size, pcr, TPM_ALG_SHA1, m->sha1, SHA1_DIGEST_SIZE);
+    if ( TPM_FAMILY(tpm->family) == TPM20 )
     {
-        u8 sha256_hash[SHA256_DIGEST_SIZE];
+        sha256sum(m->sha256, data, size);
+        digest_table_add(data, size, pcr, TPM_ALG_SHA256, m->sha256,
+                         SHA256_DIGEST_SIZE);
+    }
 
-        sha256sum(sha256_hash, data, size);
-        print("shasum calculated:\n");
-        hexdump(sha256_hash, SHA256_DIGEST_SIZE);
-        tpm_extend_pcr(tpm, pcr, TPM_ALG_SHA256, &sha256_hash[0]);
+    record_pending(tpm, m, EV_TYPE_SLAUNCH, ev);
+}
 
-        log_event_tpm20(pcr, hash, sha256_hash, ev);
+/* As measure(), but as a Merkle tree of chunks, see merkle.h */
+static void measure_merkle(struct tpm *tpm, void *data, u64 size, u32 pcr,
+                           struct event_str ev)
+{
+    bool sha256 = TPM_FAMILY(tpm->family) == TPM20;
+    struct skl_merkle_event hdr = {
+        .magic = SKL_MERKLE_MAGIC,
+        .version = SKL_MERKLE_VERSION,
+        .chunk_shift = MERKLE_CHUNK_SHIFT,
+        .size = size,
+    };
+    u64 i, n = merkle_chunks(size), off, len;
+    struct merkle t;
+    struct pending *m = next_pending(tpm, pcr);
+    char *p;
+
+    merkle_init(&t, size, sha256);
+
+    for ( i = 0; i < n; i++ )
+    {
+        off = i << MERKLE_CHUNK_SHIFT;
+        len = size - off < MERKLE_CHUNK_SIZE ? size - off : MERKLE_CHUNK_SIZE;
+
+        /* m is only scratch space until the tree is finished */
+        sha1sum(m->sha1, data + off, len);
+        if ( sha256 )
+            sha256sum(m->sha256, data + off, len);
+        merkle_add(&t, m->sha1, m->sha256);
     }
 
-    print("PCR extended\n");
+    merkle_finish(&t, &hdr, m->sha1, m->sha256);
+
+    /* The header goes ahead of the description, in the same event */
+    p = arena_alloc(sizeof(hdr) + ev.len);
+    memcpy(p, &hdr, sizeof(hdr));
+    memcpy(p + sizeof(hdr), ev.str, ev.len);
+    record_pending(tpm, m, EV_TYPE_SLAUNCH_MERKLE,
+                   (struct event_str){ p, sizeof(hdr) + ev.len });
+    arena_free(p);
+}
+
+/*
+ * For payloads and modules, which the bootloader may want as trees.  They are
+ * measured as one stream after all if the arena can't hold the tree, or the
+ * event it is logged with.
+ */
+static void measure_object(struct tpm *tpm, void *data, u64 size, u32 pcr,
+                           struct event_str ev)
+{
+    if ( merkle_enabled() && (measure_flags & SKL_MEASURE_MERKLE) &&
+         arena_avail() >= merkle_arena_size(size) &&
+         arena_avail() >= sizeof(struct skl_merkle_event) + ev.len )
+        measure_merkle(tpm, data, size, pcr, ev);
+    else
+        measure(tpm, data, size, pcr, ev);
+}
+
+/* Called once the TPM is ready */
+static void extend_composites(struct tpm *tpm)
+{
+    static const struct event_str ev[] = {
+        EVENT_STR("Measured composite into PCR17"),
+        EVENT_STR("Measured composite into PCR18"),
+    };
+    struct composite *c;
+    int i;
+
+    for ( i = 0; i < ARRAY_SIZE(composite); i++ )
+    {
+        c = &composite[i];
+        if ( !c->count )
+            continue;
+
+        log_digests(tpm, 17 + i, EV_TYPE_SLAUNCH, c->sha1, c->sha256, ev[i]);
+        extend_digests(tpm, 17 + i, c->sha1, c->sha256);
+    }
 }
 
 /*
@@ -85,6 +334,17 @@ static inline void *is_in_kernel(struct boot_params *bp, void *ptr)
     return ptr;
 }
 
+/* Length of the command line, up to the most the kernel accepts */
+static u32 get_cmdline_len(struct boot_params *bp, const char *cmdline)
+{
+    u32 len = 0;
+
+    while ( len < bp->cmdline_size && cmdline[len] )
+        len++;
+
+    return len;
+}
+
 static inline struct kernel_info *get_kernel_info(struct boot_params *bp)
 {
     return is_in_kernel(bp, _p(bp->code32_start + bp->kern_info_offset));
@@ -102,15 +362,25 @@ static inline void *get_kernel_entry(struct boot_params *bp,
     return is_in_kernel(bp, _p(bp->code32_start + mle_hdr->sl_stub_entry));
 }
 
-/*
- * Even though die() has both __attribute__((noreturn)) and unreachable(),
- * Clang still complains if it isn't repeated here.
- */
-static void __attribute__((noreturn)) reboot(void)
+/* A region to measure, given by physical address, maybe above 4G */
+static void *map_measured(u64 addr, u64 size)
 {
-    print("Rebooting now...");
-    die();
-    unreachable();
+    void *p = map_phys(addr, size);
+
+    if ( p == NULL )
+    {
+        print("Can't map region\n");
+        reboot();
+    }
+
+    return p;
+}
+
+/* As measure(), for a region given by physical address */
+static void measure_phys(struct tpm *tpm, u64 addr, u64 size, u32 pcr,
+                         struct event_str ev)
+{
+    measure(tpm, map_measured(addr, size), size, pcr, ev);
 }
 
 #ifdef TEST_DMA
@@ -155,8 +425,7 @@ static void do_dma(void)
 
 static void iommu_setup(void)
 {
-    u32 iommu_cap;
-    volatile u64 iommu_done __attribute__ ((aligned (8))) = 0;
+    u32 nr_iommus, failed;
 
 #ifdef TEST_DMA
     memset(_p(1), 0xcc, 0x20); //_p(0) gives a null-pointer error
@@ -176,7 +445,7 @@ static void iommu_setup(void)
 #endif
 
     pci_init();
-    iommu_cap = iommu_locate();
+    nr_iommus = iommu_locate();
 
     /*
      * SKINIT enables protection against DMA access from devices for SLB
@@ -198,17 +467,22 @@ static void iommu_setup(void)
      *        configured before SKINIT
      */
 
-    if ( iommu_cap == 0 || iommu_load_device_table(iommu_cap, &iommu_done) )
+    if ( nr_iommus == 0 || (failed = iommu_load_device_table()) == nr_iommus )
     {
-        if ( iommu_cap )
-            print("IOMMU disabled by a firmware, please check your settings\n");
+        if ( nr_iommus )
+            print("IOMMU disabled by firmware\n");
 
-        print("Couldn't set up IOMMU, DMA attacks possible!\n");
+        print("No IOMMU, DMA possible\n");
     }
     else
     {
+        if ( failed )
+            print("Some IOMMUs disabled, DMA possible\n");
+
+        /* Expected to fail, puts the IOMMUs into the fail-safe state. */
+        iommu_fail_safe();
+
         /* Turn off SLB protection, try again */
-        print("Disabling SLB protection\n");
         disable_memory_protection();
 
 #ifdef TEST_DMA
@@ -235,15 +509,19 @@ static void iommu_setup(void)
         hexdump(_p(0), 0x30);
 #endif
 
-        iommu_load_device_table(iommu_cap, &iommu_done);
-        print("Flushing IOMMU cache");
-        while ( !iommu_done )
-            print(".");
+        iommu_load_device_table();
 
-        print("\nIOMMU set\n");
+        /*
+         * Don't wait for the flush here, TPM bring-up can proceed in the
+         * meantime.  skl_main() joins it before anything outside the SLB is
+         * touched.
+         */
+        iommu_flush_submit();
     }
 
 #ifdef TEST_DMA
+    iommu_flush_wait();
+
     memset(_p(1), 0xcc, 0x20);
     print("before DMA:\n");
     hexdump(_p(0), 0x30);
@@ -286,13 +564,12 @@ static asm_return_t skl_linux(struct tpm *tpm, struct skl_tag_boot_linux *skl_ta
     struct kernel_info *ki;
     struct mle_header *mle_header;
     void *pm_kernel_entry;
+    char *cmdline;
+    u64 addr;
 
     /* The Zero Page with the boot_params and legacy header */
     bp = _p(skl_tag->zero_page);
 
-    print("\ncode32_start ");
-    print_p(_p(bp->code32_start));
-
     if ( bp->version                            < 0x020f
          || (ki = get_kernel_info(bp))         == NULL
          || ki->header                         != KERNEL_INFO_HEADER
@@ -302,53 +579,161 @@ static asm_return_t skl_linux(struct tpm *tpm, struct skl_tag_boot_linux *skl_ta
          || mle_header->uuid[2]                != MLE_UUID2
          || mle_header->uuid[3]                != MLE_UUID3 )
     {
-        print("\nKernel is too old or MLE header not present.\n");
+        print("No MLE header\n");
         reboot();
     }
 
-    print("\nmle_header\n");
-    hexdump(mle_header, sizeof(struct mle_header));
-
     pm_kernel_entry = get_kernel_entry(bp, mle_header);
 
     if ( pm_kernel_entry == NULL )
     {
-        print("\nBad kernel entry in MLE header.\n");
+        print("Bad MLE kernel entry\n");
         reboot();
     }
 
     /* extend TB Loader code segment into PCR17 */
-    extend_pcr(tpm, _p(bp->code32_start), bp->syssize << 4, 17,
-               "Measured Kernel into PCR17");
+    measure(tpm, _p(bp->code32_start), bp->syssize << 4, 17,
+            EVENT_STR("Measured Kernel into PCR17"));
 
-    tpm_relinquish_locality(tpm);
-    free_tpm(tpm);
+    /*
+     * The initrd and command line too, so that the kernel's Secure Launch
+     * stub doesn't have to hash them again with its slower early code.
+     * Either may be above 4G, with the ext_* fields holding the top halves.
+     */
+    if ( bp->ramdisk_size || bp->ext_ramdisk_size )
+        measure_phys(tpm, (u64)bp->ext_ramdisk_image << 32 | bp->ramdisk_image,
+                     (u64)bp->ext_ramdisk_size << 32 | bp->ramdisk_size, 17,
+                     EVENT_STR("Measured initrd into PCR17"));
 
-    /* End of the line, off to the protected mode entry into the kernel */
-    print("pm_kernel_entry:\n");
-    hexdump(pm_kernel_entry, 0x100);
-    print("zero_page:\n");
-    hexdump(bp, 0x280);
-    print("skl_base:\n");
-    hexdump(_start, 0x100);
-    print("device_table:\n");
-    hexdump(device_table, 0x100);
-    print("command_buf:\n");
-    hexdump(command_buf, 0x1000);
-    print("event_log:\n");
-    hexdump(event_log, 0x1000);
-
-    print("skl_main() is about to exit\n");
+    addr = (u64)bp->ext_cmd_line_ptr << 32 | bp->cmd_line_ptr;
+    if ( addr )
+    {
+        cmdline = map_phys(addr, bp->cmdline_size);
+        if ( cmdline == NULL )
+        {
+            print("Can't map command line\n");
+            reboot();
+        }
+
+        measure(tpm, cmdline, get_cmdline_len(bp, cmdline), 18,
+                EVENT_STR("Measured Kernel command line into PCR18"));
+    }
 
     return (asm_return_t){ pm_kernel_entry, bp };
 }
 
+/*
+ * Length of the next run of loadable sections, from section *i on, which are
+ * contiguous in memory.  Its address is returned in *start, 0 when no more.
+ * The sections are Elf32_Shdr or Elf64_Shdr, as entsize says.
+ */
+static u64 elf_next_range(struct multiboot_tag_elf_sections *es, u32 *i,
+                          u32 *start)
+{
+    u64 len = 0, size;
+    u32 addr;
+
+    for ( ; *i < es->num; (*i)++ )
+    {
+        /* sh_type, and the bits of sh_flags used, are where in both */
+        Elf32_Shdr *sh = (void *)&es->sections[es->entsize * *i];
+        Elf64_Shdr *sh64 = (void *)sh;
+
+        if ( !(sh->sh_flags & SHF_ALLOC) || sh->sh_type == SHT_NOBITS )
+            continue;
+
+        addr = sh->sh_addr;
+        size = sh->sh_size;
+        if ( es->entsize == sizeof(*sh64) )
+        {
+            /* Anything above 4G is too big to be measured where it is */
+            addr = sh64->sh_addr;
+            size = sh64->sh_size;
+            if ( (sh64->sh_addr | size) >> 32 )
+                size = 1ULL << 32;
+        }
+        if ( size == 0 )
+            continue;
+
+        if ( len == 0 )
+            *start = addr;
+        else if ( addr != *start + len )
+            break;
+
+        len += size;
+    }
+
+    return len;
+}
+
+/*
+ * Measures every loadable section of the kernel as one event, hashing the
+ * ranges they cover in turn.  The first one is where the kernel was loaded,
+ * at base, the rest keep their offsets from it.  Padding between sections
+ * isn't measured.
+ */
+static void measure_elf(struct tpm *tpm, struct multiboot_tag_elf_sections *es,
+                        void *base)
+{
+    struct pending *m = next_pending(tpm, 17);
+    union {
+        SHA1_CONTEXT sha1;
+        struct sha256_state sha256;
+    } *ctx;                     /* From the arena, the stack is too small */
+    u32 i, start, first = 0;
+    u64 len, end = 0;
+
+    if ( !base || (es->entsize != sizeof(Elf32_Shdr) &&
+                   es->entsize != sizeof(Elf64_Shdr))
+         || es->size < sizeof(*es) + (u64)es->num * es->entsize )
+        goto bad;
+
+    /* The ranges have to be in order, and stay below 4G once moved to base. */
+    for ( i = 0; (len = elf_next_range(es, &i, &start)) != 0; )
+    {
+        if ( end == 0 )
+            first = start;
+
+        if ( start < end )
+            goto bad;
+
+        end = start + len;
+        if ( end >= (1ULL << 32) || end - first + _u(base) >= (1ULL << 32) )
+            goto bad;
+    }
+
+    ctx = arena_alloc(sizeof(*ctx));
+
+    sha1_init(&ctx->sha1);
+    for ( i = 0; (len = elf_next_range(es, &i, &start)) != 0; )
+        sha1_update(&ctx->sha1, base + (start - first), len);
+    sha1_final(&ctx->sha1, m->sha1);
+
+    if ( TPM_FAMILY(tpm->family) == TPM20 )
+    {
+        sha256_init(&ctx->sha256);
+        for ( i = 0; (len = elf_next_range(es, &i, &start)) != 0; )
+            sha256_update(&ctx->sha256, base + (start - first), len);
+        sha256_final(&ctx->sha256, m->sha256);
+    }
+
+    arena_free(ctx);
+
+    record_pending(tpm, m, EV_TYPE_SLAUNCH,
+                   EVENT_STR("Measured Kernel into PCR17"));
+    return;
+
+ bad:
+    print("Bad ELF sections tag\n");
+    reboot();
+}
+
 static asm_return_t skl_multiboot2(struct tpm *tpm, struct skl_tag_boot_mb2 *skl_tag)
 {
     void *kernel_entry;
     u32 kernel_size, mbi_len;
     struct multiboot_tag *tag;
-    int i;
+    unsigned int nr_elf = 0;
 
     /* This is MBI header, not a tag, but their structures are similar enough.
      * Note that 'size' offsets are reversed in those two! */
@@ -362,78 +747,63 @@ static asm_return_t skl_multiboot2(struct tpm *tpm, struct skl_tag_boot_mb2 *skl
     /* Extend PCR18 with MBI structure's hash; this includes all cmdlines.
      * Use 'type' and not 'size', as their offsets are swapped in the header! */
     mbi_len = tag->type;
-    extend_pcr(tpm, &tag, mbi_len, 18, "Measured MBI into PCR18");
+    measure(tpm, tag, mbi_len, 18, EVENT_STR("Measured MBI into PCR18"));
 
     tag++;
 
+    /*
+     * A single pass over the MBI, measuring modules and the kernel as their
+     * tags turn up, so PCR17 is extended in MBI order.  GRUB2 puts the ELF
+     * sections tag after all module tags, so for it the kernel comes last.
+     */
     while ( tag->type )
     {
-        if ( kernel_entry && kernel_size )
-            break;
-
-        /* If the entry point wasn't passed by a bootloader, we can only assume
-         * that it starts at the kernel base address (true at least for Xen) */
-        if ( !kernel_entry && tag->type == MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR )
-        {
-            struct multiboot_tag_load_base_addr *ba = (void *)tag;
-            kernel_entry = _p(ba->load_base_addr);
-            print("kernel_entry ");
-            print_p(kernel_entry);
-            print("\n");
-        }
-
-        /* This assumes that ELF has only one PROGBITS section, and that section
-         * is the first one (i.e. it is loaded at load_base_addr). It is true
-         * for Xen, but may not always the case.
-         *
-         * Also, GRUB2 creates this tag after all module tags, so separate loop
-         * is needed for consistent order of PCR extension operations. */
-        if ( !kernel_size && tag->type == MULTIBOOT_TAG_TYPE_ELF_SECTIONS )
+        switch ( tag->type )
         {
-            struct multiboot_tag_elf_sections *es_tag = (void *)tag;
-            for ( i = 0; i < es_tag->num; i++ )
+        /* If the entry point wasn't passed by a bootloader, we can only assume
+         * that it starts at the kernel base address (true at least for Xen).
+         * GRUB2 puts this tag ahead of the ELF sections one. */
+        case MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR:
+            if ( !kernel_entry )
             {
-                Elf32_Shdr *sh = (void *)&es_tag->sections[es_tag->entsize * i];
-                if ( sh->sh_type == SHT_PROGBITS )
-                {
-                    kernel_size = sh->sh_size;
-                    print("kernel_size ");
-                    print_p(_p(kernel_size));
-                    print("\n");
-                    break;
-                }
+                struct multiboot_tag_load_base_addr *ba = (void *)tag;
+                kernel_entry = _p(ba->load_base_addr);
             }
-        }
-
-        tag = multiboot_next_tag(tag);
-    }
-
-    extend_pcr(tpm, kernel_entry, kernel_size, 17,
-               "Measured Kernel into PCR17");
+            break;
 
-    tag = _p(skl_tag->mbi);
-    tag++;
+        /* A size from the bootloader means exactly that many bytes from
+         * kernel_entry, without looking at the sections. */
+        case MULTIBOOT_TAG_TYPE_ELF_SECTIONS:
+            if ( nr_elf++ )
+                break;
+            if ( kernel_size )
+                measure(tpm, kernel_entry, kernel_size, 17,
+                        EVENT_STR("Measured Kernel into PCR17"));
+            else
+                measure_elf(tpm, (void *)tag, kernel_entry);
+            break;
 
-    while ( tag->type )
-    {
-        if ( tag->type == MULTIBOOT_TAG_TYPE_MODULE )
+        case MULTIBOOT_TAG_TYPE_MODULE:
         {
             struct multiboot_tag_module *mod = (void *)tag;
-            print("Module '");
-            print(mod->cmdline);
-            print("' [");
-            print_p(_p(mod->mod_start));
-            print_p(_p(mod->mod_end));
-            print("]\n");
-            extend_pcr(tpm, _p(mod->mod_start), mod->mod_end - mod->mod_start,
-                       17, mod->cmdline);
+            measure_object(tpm, _p(mod->mod_start),
+                           mod->mod_end - mod->mod_start, 17,
+                           (struct event_str){ mod->cmdline,
+                                               strlen(mod->cmdline) });
+            break;
+        }
         }
 
         tag = multiboot_next_tag(tag);
     }
 
+    /* Without ELF sections, there is only the bootloader's word to go on. */
+    if ( nr_elf == 0 )
+        measure(tpm, kernel_entry, kernel_size, 17,
+                EVENT_STR("Measured Kernel into PCR17"));
+
     /* Safety checks */
-    if ( tag->size != 8
+    if ( tag->size != 8 || nr_elf > 1
          || _p(multiboot_next_tag(tag)) > _p(skl_tag->mbi) + mbi_len )
     {
         print("MBI safety checks failed\n");
@@ -447,18 +817,58 @@ static asm_return_t skl_multiboot2(struct tpm *tpm, struct skl_tag_boot_mb2 *skl
 
 static asm_return_t skl_simple_payload(struct tpm *tpm, struct skl_tag_boot_simple_payload *skl_tag)
 {
-    extend_pcr(tpm, _p(skl_tag->base), skl_tag->size, 17, "Measured payload into PCR17");
+    measure_object(tpm, _p(skl_tag->base), skl_tag->size, 17,
+                   EVENT_STR("Measured payload into PCR17"));
+
+    boot_protocol = SIMPLE_PAYLOAD;
+
+    return (asm_return_t){ _p(skl_tag->entry), _p(skl_tag->arg) };
+}
+
+static asm_return_t skl_simple_payload64(struct tpm *tpm,
+                                         struct skl_tag_boot_simple_payload64 *skl_tag)
+{
+    measure_object(tpm, map_measured(skl_tag->base, skl_tag->size),
+                   skl_tag->size, 17, EVENT_STR("Measured payload into PCR17"));
 
     boot_protocol = SIMPLE_PAYLOAD;
 
     return (asm_return_t){ _p(skl_tag->entry), _p(skl_tag->arg) };
 }
 
+/* Measures, in place, each region passed with SKL_TAG_SETUP_INDIRECT */
+static void skl_setup_indirect(struct tpm *tpm)
+{
+    struct skl_tag_setup_indirect *t = (void *)&bootloader_data;
+    struct setup_indirect *ind;
+
+    while ( (t = next_of_type(t, SKL_TAG_SETUP_INDIRECT)) != NULL )
+    {
+        ind = &t->data.indirect;
+
+        if ( t->hdr.len                           <= sizeof(*t)
+             || t->label[t->hdr.len - sizeof(*t) - 1] != '\0'
+             || t->data.type                      != SETUP_INDIRECT
+             || (t->pcr != 17 && t->pcr != 18) )
+        {
+            print("Bad setup_indirect tag\n");
+            reboot();
+        }
+
+        /* The label's length is known from the tag, having checked its NUL */
+        measure_phys(tpm, ind->addr, ind->len, t->pcr,
+                     (struct event_str){ t->label,
+                                         t->hdr.len - sizeof(*t) - 1 });
+    }
+}
+
 asm_return_t skl_main(void)
 {
     asm_return_t ret;
     struct tpm *tpm;
     struct skl_tag_hdr *t = (struct skl_tag_hdr*) &bootloader_data;
+    void *table;
+    u32 table_size;
 
     /*
      * Now in 64b mode, paging is setup. This is the launching point. We can
@@ -469,36 +879,67 @@ asm_return_t skl_main(void)
      */
     pci_init();
 
+    /* Before iommu_setup(), as the tags may say where ACPI tables are */
+    if ( tags_index() )
+    {
+        print("Bad tags\n");
+        reboot();
+    }
+
     /* Disable memory protection and setup IOMMU */
     iommu_setup();
 
-    if ( t->type                              != SKL_TAG_TAGS_SIZE
-         || t->len                            != sizeof(struct skl_tag_tags_size)
-         || end_of_tags()                      > _p(_start + SLB_SIZE)
-         || (t = next_of_type(t, SKL_TAG_END)) == NULL
-         || _p(t) + t->len                    != end_of_tags())
+    /* Before arena_init(), which takes the L2 tables this frees up */
+    map_gigabytes();
+    arena_init();
+
+    if ( digest_table_init() )
     {
-        print("Bad bootloader data format\n");
+        print("Bad digest table tag\n");
         reboot();
     }
 
+    t = next_of_type(&bootloader_data, SKL_TAG_MEASURE_POLICY);
+    if ( t != NULL )
+        measure_flags = ((struct skl_tag_measure_policy *)t)->flags;
+
     /*
      * TODO Note these functions can fail but there is no clear way to
      * report the error unless SKINIT has some resource to do this. For
      * now, if an error is returned, this code will most likely just crash.
      */
     tpm = enable_tpm();
+    if ( tpm == NULL )
+    {
+        print("No usable TPM\n");
+        reboot();
+    }
     tpm_request_locality(tpm, 2);
     event_log_init(tpm);
 
-    /* Now that we have TPM and event log, measure bootloader data */
-    extend_pcr(tpm, &bootloader_data, bootloader_data.size, 18,
-               "Measured bootloader data into PCR18");
+    /*
+     * Nothing outside the SLB may be measured before the IOMMUs use the new
+     * device table, or a device could change it afterwards.  Give up rather
+     * than launch unprotected if they never get there.
+     */
+    if ( iommu_flush_wait() == -EBUSY )
+    {
+        print("IOMMU flush timed out\n");
+        reboot();
+    }
+
+    /*
+     * The TPM may still be getting ready for commands, which doesn't stop us
+     * from hashing everything in the meantime.  Measure bootloader data first.
+     */
+    tpm_started = rdtsc();
+    measure(tpm, &bootloader_data, bootloader_data.size, 18,
+            EVENT_STR("Measured bootloader data into PCR18"));
 
     t = next_of_class(&bootloader_data, SKL_TAG_BOOT_CLASS);
     if ( t == NULL || next_of_class(t, SKL_TAG_BOOT_CLASS) != NULL )
     {
-        print("No boot tag or multiple boot tags\n");
+        print("Not one boot tag\n");
         reboot();
     }
 
@@ -513,45 +954,44 @@ asm_return_t skl_main(void)
     case SKL_TAG_BOOT_SIMPLE:
         ret = skl_simple_payload(tpm, (struct skl_tag_boot_simple_payload *)t);
         break;
+    case SKL_TAG_BOOT_SIMPLE64:
+        ret = skl_simple_payload64(tpm,
+                                   (struct skl_tag_boot_simple_payload64 *)t);
+        break;
     default:
-        print("Unknown kernel boot protocol\n");
+        print("Bad boot tag\n");
         reboot();
     }
 
+    skl_setup_indirect(tpm);
+
+    /* Last, so that it has everything else in it */
+    table = digest_table_finish(&table_size);
+    if ( table != NULL )
+        measure(tpm, table, table_size, 18,
+                EVENT_STR("Measured digest table into PCR18"));
+
+    flush_pending(tpm);
+    extend_composites(tpm);
+
     tpm_relinquish_locality(tpm);
     free_tpm(tpm);
 
     /* End of the line, off to the protected mode entry into the kernel */
-    print("pm_kernel_entry:\n");
-    hexdump(ret.pm_kernel_entry, 0x100);
-    print("zero_page:\n");
-    hexdump(ret.zero_page, 0x280);
-    print("skl_base:\n");
-    hexdump(_start, 0x100);
-    print("bootloader_data:\n");
-    hexdump(&bootloader_data, bootloader_data.size);
-
-    t = next_of_type(&bootloader_data, SKL_TAG_EVENT_LOG);
-    if ( t != NULL )
-    {
-        print("TPM event log:\n");
-        hexdump(_p(((struct skl_tag_evtlog *)t)->address),
-                ((struct skl_tag_evtlog *)t)->size);
-    }
-
     if ( skl_stack_canary != STACK_CANARY )
     {
-        print("Stack is too small, possible corruption\n");
+        print("Stack overflow\n");
         reboot();
     }
 
-    print("skl_main() is about to exit\n");
-
     return ret;
 }
 
 static void __maybe_unused build_assertions(void)
 {
+    BUILD_BUG_ON(offsetof(struct boot_params, ext_ramdisk_image) != 0x0c0);
+    BUILD_BUG_ON(offsetof(struct boot_params, ext_ramdisk_size)  != 0x0c4);
+    BUILD_BUG_ON(offsetof(struct boot_params, ext_cmd_line_ptr)  != 0x0c8);
     BUILD_BUG_ON(offsetof(struct boot_params, tb_dev_map)        != 0x0d8);
     BUILD_BUG_ON(offsetof(struct boot_params, syssize)           != 0x1f4);
     BUILD_BUG_ON(offsetof(struct boot_params, version)           != 0x206);
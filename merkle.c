@@ -0,0 +1,112 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <defs.h>
+#include <types.h>
+#include <string.h>
+#include <arena.h>
+#include <sha1sum.h>
+#include <sha256.h>
+#include <merkle.h>
+
+/* out := H(prefix || a || b), b being a digest of the bank's size */
+static void hash_with(bool sha256, u8 *out, u8 prefix, const void *a,
+                      u32 a_size, const u8 *b)
+{
+    u8 buf[1 + 2 * SHA256_DIGEST_SIZE];
+    u32 size = sha256 ? SHA256_DIGEST_SIZE : SHA1_DIGEST_SIZE;
+
+    buf[0] = prefix;
+    memcpy(buf + 1, a, a_size);
+    memcpy(buf + 1 + a_size, b, size);
+
+    if ( sha256 )
+        sha256sum(out, buf, 1 + a_size + size);
+    else
+        sha1sum(out, buf, 1 + a_size + size);
+}
+
+/* Subtree i becomes the parent of itself and subtree i + 1 */
+static void merge(struct merkle *t, unsigned int i)
+{
+    struct merkle_node *n = &t->nodes[i];
+
+    hash_with(false, n->sha1, MERKLE_NODE, n->sha1, SHA1_DIGEST_SIZE,
+              n[1].sha1);
+    if ( t->sha256 )
+        hash_with(true, n->sha256, MERKLE_NODE, n->sha256, SHA256_DIGEST_SIZE,
+                  n[1].sha256);
+}
+
+static unsigned int depth_of(u64 size)
+{
+    unsigned int depth = 0;
+    u64 n;
+
+    for ( n = merkle_chunks(size); n; n >>= 1 )
+        depth++;
+
+    return depth;
+}
+
+u32 merkle_arena_size(u64 size)
+{
+    return depth_of(size) * sizeof(struct merkle_node);
+}
+
+void merkle_init(struct merkle *t, u64 size, bool sha256)
+{
+    t->leaves = 0;
+    t->top = 0;
+    t->sha256 = sha256;
+    t->nodes = arena_alloc(merkle_arena_size(size));
+}
+
+void merkle_add(struct merkle *t, const u8 *sha1, const u8 *sha256)
+{
+    unsigned int top = t->top;
+    u64 n;
+
+    memcpy(t->nodes[top].sha1, sha1, SHA1_DIGEST_SIZE);
+    if ( t->sha256 )
+        memcpy(t->nodes[top].sha256, sha256, SHA256_DIGEST_SIZE);
+
+    /* As carries in a binary count, equal sized subtrees are joined */
+    for ( n = t->leaves; n & 1; n >>= 1 )
+        merge(t, --top);
+
+    t->top = top + 1;
+    t->leaves++;
+}
+
+void merkle_finish(struct merkle *t, const struct skl_merkle_event *ev,
+                   u8 *sha1, u8 *sha256)
+{
+    unsigned int i;
+
+    BUILD_BUG_ON(sizeof(*ev) > SHA256_DIGEST_SIZE);
+
+    /* What is left gets smaller to the right, which is the RFC 6962 shape */
+    for ( i = t->top - 1; i > 0; i-- )
+        merge(t, i - 1);
+
+    hash_with(false, sha1, MERKLE_ROOT, ev, sizeof(*ev), t->nodes->sha1);
+    if ( t->sha256 )
+        hash_with(true, sha256, MERKLE_ROOT, ev, sizeof(*ev),
+                  t->nodes->sha256);
+
+    arena_free(t->nodes);
+}
@@ -0,0 +1,121 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <defs.h>
+#include <boot.h>
+#include <types.h>
+#include <paging.h>
+
+#ifdef __x86_64__
+/* From head.S.  Only L3[0..3] are set up, pointing at the L2 tables. */
+extern u64 l3_identmap[512];
+
+/*
+ * No enabled variable MTRR may cover part of the GB at base but not all of
+ * it.  A range either matches every address in it, none, or some, by the
+ * mask bits inside the GB.
+ */
+static bool mtrr_uniform(u64 base)
+{
+    u64 in_gb = (GIGABYTE - 1) & ~(PAGE_SIZE - 1ULL), mask;
+    unsigned int i, n;
+
+    if ( !(rdmsr(IA32_MTRR_DEF_TYPE) & MTRR_DEF_TYPE_E) )
+        return true;
+
+    n = rdmsr(IA32_MTRR_CAP) & MTRR_CAP_VCNT;
+    for ( i = 0; i < n; i++ )
+    {
+        mask = rdmsr(IA32_MTRR_PHYSMASK(i));
+        if ( !(mask & MTRR_PHYSMASK_VALID) )
+            continue;
+
+        mask &= ~(PAGE_SIZE - 1ULL);
+        if ( (mask & in_gb) &&
+             !((base ^ rdmsr(IA32_MTRR_PHYSBASE(i))) & mask & ~in_gb) )
+            return false;
+    }
+
+    return true;
+}
+
+void map_gigabytes(void)
+{
+    u32 eax, ebx, ecx, edx;
+    bool changed = false;
+    unsigned int i;
+
+    cpuid(CPUID_EXT_FEATURES, 0, &eax, &ebx, &ecx, &edx);
+    if ( !(edx & CPUID_EXT_EDX_PAGE1GB) )
+        return;
+
+    for ( i = 1; i < 4; i++ )
+        if ( mtrr_uniform((u64)i << L3_PT_SHIFT) )
+        {
+            l3_identmap[i] = ((u64)i << L3_PT_SHIFT) + _PAGE_PSE + _PAGE_AD +
+                             _PAGE_RW + _PAGE_PRESENT;
+            changed = true;
+        }
+
+    /* The L2 entries these replace may be cached, and L2 goes to the arena */
+    if ( changed )
+        write_cr3(read_cr3());
+}
+
+static void *map_high(u64 addr, u64 end)
+{
+    u32 eax, ebx, ecx, edx;
+    unsigned int i;
+
+    cpuid(CPUID_EXT_FEATURES, 0, &eax, &ebx, &ecx, &edx);
+    if ( end > MAP_PHYS_LIMIT || !(edx & CPUID_EXT_EDX_PAGE1GB) )
+        return NULL;
+
+    /*
+     * Not present entries aren't cached by the TLB, so there is nothing to
+     * flush after filling them in.
+     */
+    for ( i = addr >> L3_PT_SHIFT; i < (end + GIGABYTE - 1) >> L3_PT_SHIFT; i++ )
+        if ( !(l3_identmap[i] & _PAGE_PRESENT) )
+            l3_identmap[i] = ((u64)i << L3_PT_SHIFT) + _PAGE_PSE + _PAGE_AD +
+                             _PAGE_RW + _PAGE_PRESENT;
+
+    return _p(addr);
+}
+#else
+/* No PAE in the 32bit build, so nothing above 4G can be reached. */
+static void *map_high(u64 addr, u64 end)
+{
+    return NULL;
+}
+
+void map_gigabytes(void)
+{
+}
+#endif
+
+void *map_phys(u64 addr, u64 size)
+{
+    u64 end = addr + size;
+
+    if ( end < addr )
+        return NULL;
+
+    if ( end <= (1ULL << 32) )
+        return _p(addr);
+
+    return map_high(addr, end);
+}
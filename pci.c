@@ -24,10 +24,14 @@
 #include <boot.h>
 #include <pci.h>
 
+#if !defined(CONFIG_PCI_CONF1) && !defined(CONFIG_PCI_ECAM)
 int (*pci_read)(unsigned int seg, unsigned int bus,
                 unsigned int devfn, int reg, int len, u32 *value);
 int (*pci_write)(unsigned int seg, unsigned int bus,
                  unsigned int devfn, int reg, int len, u32 value);
+#endif
+
+#ifndef CONFIG_PCI_ECAM
 
 /*
  * Functions for accessing PCI base (first 256 bytes) and extended
@@ -39,9 +43,8 @@ int (*pci_write)(unsigned int seg, unsigned int bus,
         (0x80000000 | ((reg & 0xF00) << 16) | (bus << 16) \
         | (devfn << 8) | (reg & 0xFC))
 
-static int pci_conf1_read(unsigned int seg, unsigned int bus,
-                          unsigned int devfn, int reg, int len,
-                          u32 *value)
+int pci_conf1_read(unsigned int seg, unsigned int bus,
+                   unsigned int devfn, int reg, int len, u32 *value)
 {
     if ( seg || (bus > 255) || (devfn > 255) || (reg > 4095) )
     {
@@ -70,9 +73,8 @@ static int pci_conf1_read(unsigned int seg, unsigned int bus,
     return 0;
 }
 
-static int pci_conf1_write(unsigned int seg, unsigned int bus,
-                           unsigned int devfn, int reg, int len,
-                           u32 value)
+int pci_conf1_write(unsigned int seg, unsigned int bus,
+                    unsigned int devfn, int reg, int len, u32 value)
 {
     if ( seg || (bus > 255) || (devfn > 255) || (reg > 4095) )
         return -EINVAL;
@@ -98,13 +100,16 @@ static int pci_conf1_write(unsigned int seg, unsigned int bus,
     return 0;
 }
 
+#endif /* !CONFIG_PCI_ECAM */
+
+#ifndef CONFIG_PCI_CONF1
 u32 mmio_base_addr;
 
 #define PCI_MMIO_ADDRESS(bus, devfn, reg) \
         _p(mmio_base_addr | (bus << 20ULL) | (devfn << 12ULL) | reg)
 
-static int pci_mmio_read(unsigned int seg, unsigned int bus,
-                   unsigned int devfn, int reg, int len, u32 *value)
+int pci_mmio_read(unsigned int seg, unsigned int bus,
+                  unsigned int devfn, int reg, int len, u32 *value)
 {
     if ( seg || (bus > 255) || (devfn > 255) || (reg > 4095) )
     {
@@ -132,8 +137,8 @@ static int pci_mmio_read(unsigned int seg, unsigned int bus,
     return 0;
 }
 
-static int pci_mmio_write(unsigned int seg, unsigned int bus,
-                    unsigned int devfn, int reg, int len, u32 value)
+int pci_mmio_write(unsigned int seg, unsigned int bus,
+                   unsigned int devfn, int reg, int len, u32 value)
 {
     if ( seg || (bus > 255) || (devfn > 255) || (reg > 4095) )
         return -EINVAL;
@@ -158,6 +163,8 @@ static int pci_mmio_write(unsigned int seg, unsigned int bus,
     return 0;
 }
 
+#endif /* !CONFIG_PCI_CONF1 */
+
 u32 pci_locate(unsigned int bus, unsigned int devfn)
 {
     u32 pci_cap_ptr;
@@ -195,9 +202,16 @@ u32 pci_locate(unsigned int bus, unsigned int devfn)
 
 void pci_init(void)
 {
-    u32 eax, edx;
+#if defined(CONFIG_PCI_ECAM)
+    u32 eax = rdmsr(0xc0010058);
+
+    /* Built without CF8/CFC accesses, there is nothing to fall back to */
+    if ( !(eax & 1) )
+        die();
 
-    asm volatile("rdmsr" : "=a"(eax), "=d"(edx) : "c"(0xc0010058));
+    mmio_base_addr = (eax & 0xfff00000);
+#elif !defined(CONFIG_PCI_CONF1)
+    u32 eax = rdmsr(0xc0010058);
 
     if ( eax & 1 )  /* MMIO configuration space is enabled */
     {
@@ -210,4 +224,5 @@ void pci_init(void)
         pci_read = &pci_conf1_read;
         pci_write = &pci_conf1_write;
     }
+#endif
 }
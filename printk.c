@@ -37,71 +37,31 @@ void print(const char * txt)
     }
 }
 
-void print_p(const void * _p)
+/* As many hex digits as a pointer has, so print_p() can use it too */
+void print_u64(u64 p)
 {
     char tmp[sizeof(void*)*2 + 5] = "0x";
     int i;
-    size_t p = (size_t)_p;
 
-    for ( i=0; i<sizeof(void*); i++ )
-    {
-        if ( (p & 0xf) >= 10 )
-            tmp[sizeof(void*)*2 + 1 - 2*i] = (p & 0xf) + 'a' - 10;
-        else
-            tmp[sizeof(void*)*2 + 1 - 2*i] = (p & 0xf) + '0';
-        p >>= 4;
-        if ( (p & 0xf) >= 10 )
-            tmp[sizeof(void*)*2 - 2*i] = (p & 0xf) + 'a' - 10;
-        else
-            tmp[sizeof(void*)*2 - 2*i] = (p & 0xf) + '0';
-        p >>= 4;
-    }
+    for ( i = sizeof(void*)*2 + 1; i >= 2; i--, p >>= 4 )
+        tmp[i] = "0123456789abcdef"[p & 0xf];
+
     tmp[sizeof(void*)*2 + 2] = ':';
     tmp[sizeof(void*)*2 + 3] = ' ';
     tmp[sizeof(void*)*2 + 4] = '\0';
     print(tmp);
 }
 
-void print_u64(u64 p)
+void print_p(const void * _p)
 {
-    char tmp[sizeof(void*)*2 + 5] = "0x";
-    int i;
-
-    for ( i=0; i<sizeof(void*); i++ )
-     {
-        if ( (p & 0xf) >= 10 )
-            tmp[sizeof(void*)*2 + 1 - 2*i] = (p & 0xf) + 'a' - 10;
-        else
-            tmp[sizeof(void*)*2 + 1 - 2*i] = (p & 0xf) + '0';
-        p >>= 4;
-        if ((p & 0xf) >= 10)
-            tmp[sizeof(void*)*2 - 2*i] = (p & 0xf) + 'a' - 10;
-        else
-            tmp[sizeof(void*)*2 - 2*i] = (p & 0xf) + '0';
-        p >>= 4;
-    }
-    tmp[sizeof(void*)*2 + 2] = ':';
-    tmp[sizeof(void*)*2 + 3] = ' ';
-    tmp[sizeof(void*)*2 + 4] = '\0';
-    print(tmp);
+    print_u64((size_t)_p);
 }
 
-static void print_b(char p)
+static void print_b(u8 p)
 {
-    char tmp[4];
-
-    if ( (p & 0xf) >= 10 )
-        tmp[1] = (p & 0xf) + 'a' - 10;
-    else
-        tmp[1] = (p & 0xf) + '0';
-    p >>= 4;
-    if ( (p & 0xf) >= 10 )
-        tmp[0] = (p & 0xf) + 'a' - 10;
-    else
-        tmp[0] = (p & 0xf) + '0';
-
-    tmp[2] = ' ';
-    tmp[3] = '\0';
+    char tmp[4] = { "0123456789abcdef"[p >> 4], "0123456789abcdef"[p & 0xf],
+                    ' ', '\0' };
+
     print(tmp);
 }
 
@@ -34,18 +34,7 @@ static inline u32 rol( u32 x, int n)
     return (x << n) | (x >> (-n & 31));
 }
 
-typedef struct {
-    u32 count;
-    union {
-        struct {
-            u32 h0, h1, h2, h3, h4;
-        };
-        u32 h[5];
-    };
-    unsigned char buf[64];
-} SHA1_CONTEXT;
-
-static void sha1_init( SHA1_CONTEXT *hd )
+void sha1_init( SHA1_CONTEXT *hd )
 {
     *hd = (SHA1_CONTEXT){
         .h0 = 0x67452301,
@@ -56,15 +45,6 @@ static void sha1_init( SHA1_CONTEXT *hd )
     };
 }
 
-static u32 sha1_blend(u32 *x, unsigned int i)
-{
-#define X(i) x[(i) & 15]
-
-    return X(i) = rol(X(i) ^ X(i - 14) ^ X(i - 8) ^ X(i - 3), 1);
-
-#undef X
-}
-
 /****************
  * Transform the message X which consists of 16 32-bit-words
  */
@@ -73,7 +53,7 @@ static void sha1_transform(SHA1_CONTEXT *hd, const void *_data)
     const u32 *data = _data;
     u32 a,b,c,d,e;
     u32 x[16];
-    int i;
+    int i, j;
 
     /* get values from the chaining vars */
     a = hd->h0;
@@ -96,54 +76,36 @@ static void sha1_transform(SHA1_CONTEXT *hd, const void *_data)
 #define F4(x,y,z)   ( x ^ y ^ z )
 
 
-#define M(i) sha1_blend(x, i)
+#define X(i) x[(i) & 15]
 #define R(a,b,c,d,e,f,k,m)  do { e += rol( a, 5 )     \
                       + f( b, c, d )  \
                       + k         \
                       + m;        \
                  b = rol( b, 30 );    \
                    } while(0)
+#define R5(f,k) do { R(a, b, c, d, e, f, k, X(i + 0)); \
+                     R(e, a, b, c, d, f, k, X(i + 1)); \
+                     R(d, e, a, b, c, f, k, X(i + 2)); \
+                     R(c, d, e, a, b, f, k, X(i + 3)); \
+                     R(b, c, d, e, a, f, k, X(i + 4)); \
+                   } while(0)
 
-    for ( i = 0; i < 15; i += 5 )
-    {
-        R(a, b, c, d, e, F1, K1, x[i + 0]);
-        R(e, a, b, c, d, F1, K1, x[i + 1]);
-        R(d, e, a, b, c, F1, K1, x[i + 2]);
-        R(c, d, e, a, b, F1, K1, x[i + 3]);
-        R(b, c, d, e, a, F1, K1, x[i + 4]);
-    }
-
-    R( a, b, c, d, e, F1, K1, x[15] );
-    R( e, a, b, c, d, F1, K1, M(16) );
-    R( d, e, a, b, c, F1, K1, M(17) );
-    R( c, d, e, a, b, F1, K1, M(18) );
-    R( b, c, d, e, a, F1, K1, M(19) );
-
-    for ( i = 20; i < 40; i += 5 )
-    {
-        R(a, b, c, d, e, F2, K2, M(i + 0));
-        R(e, a, b, c, d, F2, K2, M(i + 1));
-        R(d, e, a, b, c, F2, K2, M(i + 2));
-        R(c, d, e, a, b, F2, K2, M(i + 3));
-        R(b, c, d, e, a, F2, K2, M(i + 4));
-    }
-
-    for ( ; i < 60; i += 5 )
-    {
-        R(a, b, c, d, e, F3, K3, M(i + 0));
-        R(e, a, b, c, d, F3, K3, M(i + 1));
-        R(d, e, a, b, c, F3, K3, M(i + 2));
-        R(c, d, e, a, b, F3, K3, M(i + 3));
-        R(b, c, d, e, a, F3, K3, M(i + 4));
-    }
-
-    for ( ; i < 80; i += 5 )
+    /*
+     * Five rounds at a time, their words of the message schedule first.
+     * F2 and F4 only differ in the constant, so they share a copy of the
+     * rounds, which keeps the whole transform small enough for the SLB.
+     */
+    for ( i = 0; i < 80; i += 5 )
     {
-        R(a, b, c, d, e, F4, K4, M(i + 0));
-        R(e, a, b, c, d, F4, K4, M(i + 1));
-        R(d, e, a, b, c, F4, K4, M(i + 2));
-        R(c, d, e, a, b, F4, K4, M(i + 3));
-        R(b, c, d, e, a, F4, K4, M(i + 4));
+        for ( j = i < 16 ? 16 : i; j < i + 5; ++j )
+            X(j) = rol(X(j) ^ X(j - 14) ^ X(j - 8) ^ X(j - 3), 1);
+
+        if ( i < 20 )
+            R5(F1, K1);
+        else if ( i >= 40 && i < 60 )
+            R5(F3, K3);
+        else
+            R5(F2, (i < 40 ? K2 : K4));
     }
 
     /* Update chaining vars */
@@ -155,9 +117,27 @@ static void sha1_transform(SHA1_CONTEXT *hd, const void *_data)
 }
 
 
-static void sha1_once(SHA1_CONTEXT *hd, const void *data, u32 len)
+/* Adds len bytes at data to the hash.  May be called any number of times. */
+void sha1_update(SHA1_CONTEXT *hd, const void *data, u64 len)
 {
-    hd->count = len;
+    unsigned int partial = hd->count & 0x3f, n;
+
+    hd->count += len;
+
+    if ( partial )
+    {
+        n = 64 - partial;
+        if ( n > len )
+            n = len;
+        memcpy(hd->buf + partial, data, n);
+        if ( partial + n < 64 )
+            return;
+
+        sha1_transform(hd, hd->buf);
+        data += n;
+        len -= n;
+    }
+
     for ( ; len >= 64; data += 64, len -= 64 )
         sha1_transform(hd, data);
 
@@ -172,7 +152,7 @@ static void sha1_once(SHA1_CONTEXT *hd, const void *data, u32 len)
  * Returns: 20 bytes representing the digest.
  */
 
-static void
+void
 sha1_final(SHA1_CONTEXT *hd, u8 hash[SHA1_DIGEST_SIZE])
 {
     unsigned int partial = hd->count & 0x3f;
@@ -190,9 +170,12 @@ sha1_final(SHA1_CONTEXT *hd, u8 hash[SHA1_DIGEST_SIZE])
     /* Pad to 56 */
     memset(hd->buf + partial, 0, 56 - partial);
 
-    /* append the 64 bit count */
-    u64 *count = (void *)&hd->buf[56];
-    *count = cpu_to_be64((u64)hd->count << 3);
+    /*
+     * append the 64 bit count.  Through memcpy(), as sha1_transform() reads
+     * buf[] as u32, which a u64 store would be free to be reordered with.
+     */
+    u64 count = cpu_to_be64((u64)hd->count << 3);
+    memcpy(&hd->buf[56], &count, sizeof(count));
     sha1_transform(hd, hd->buf);
 
     u32 *p = (void *)hash;
@@ -200,12 +183,12 @@ sha1_final(SHA1_CONTEXT *hd, u8 hash[SHA1_DIGEST_SIZE])
         p[i] = be32_to_cpu(hd->h[i]);
 }
 
-void sha1sum(u8 hash[static SHA1_DIGEST_SIZE], const void *ptr, u32 len)
+void sha1sum(u8 hash[static SHA1_DIGEST_SIZE], const void *ptr, u64 len)
 {
     SHA1_CONTEXT ctx;
 
     sha1_init(&ctx);
-    sha1_once(&ctx, ptr, len);
+    sha1_update(&ctx, ptr, len);
     sha1_final(&ctx, hash);
 }
 
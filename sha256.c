@@ -20,13 +20,6 @@
 #include <sha256.h>
 #include <string.h>
 
-#define SHA256_BLOCK_SIZE   64
-
-struct sha256_state {
-    u32 state[SHA256_DIGEST_SIZE / 4];
-    u32 count;
-    u8 buf[SHA256_BLOCK_SIZE];
-};
 
 static inline u32 ror32(u32 word, unsigned int shift)
 {
@@ -81,7 +74,7 @@ static void sha256_transform(u32 *state, const void *_input)
     const u32 *input = _input;
     u32 a, b, c, d, e, f, g, h, t1, t2;
     u32 W[16];
-    int i;
+    int i, j;
 
     /* load the input */
     for ( i = 0; i < 16; i++ )
@@ -91,52 +84,40 @@ static void sha256_transform(u32 *state, const void *_input)
     a = state[0];  b = state[1];  c = state[2];  d = state[3];
     e = state[4];  f = state[5];  g = state[6];  h = state[7];
 
-    /* now iterate */
-    for ( i = 0; i < 16; i += 8 )
+    /*
+     * Now iterate, 4 rounds at a time.  Past the first 16, the message
+     * schedule for those 4 is worked out up front, so that all of them can
+     * share the one copy of the rounds, after which the working variables
+     * are swapped back into place.
+     */
+    for ( i = 0; i < 64; i += 4 )
     {
-        t1 = h + e1(e) + Ch(e, f, g) + K[i + 0] + W[i + 0];
+        const u32 *w = &W[i & 15];
+
+        if ( i >= 16 )
+            for ( j = i; j < i + 4; j++ )
+                sha256_blend(W, j);
+
+        t1 = h + e1(e) + Ch(e, f, g) + K[i + 0] + w[0];
         t2 = e0(a) + Maj(a, b, c);    d += t1;    h = t1 + t2;
-        t1 = g + e1(d) + Ch(d, e, f) + K[i + 1] + W[i + 1];
+        t1 = g + e1(d) + Ch(d, e, f) + K[i + 1] + w[1];
         t2 = e0(h) + Maj(h, a, b);    c += t1;    g = t1 + t2;
-        t1 = f + e1(c) + Ch(c, d, e) + K[i + 2] + W[i + 2];
+        t1 = f + e1(c) + Ch(c, d, e) + K[i + 2] + w[2];
         t2 = e0(g) + Maj(g, h, a);    b += t1;    f = t1 + t2;
-        t1 = e + e1(b) + Ch(b, c, d) + K[i + 3] + W[i + 3];
+        t1 = e + e1(b) + Ch(b, c, d) + K[i + 3] + w[3];
         t2 = e0(f) + Maj(f, g, h);    a += t1;    e = t1 + t2;
-        t1 = d + e1(a) + Ch(a, b, c) + K[i + 4] + W[i + 4];
-        t2 = e0(e) + Maj(e, f, g);    h += t1;    d = t1 + t2;
-        t1 = c + e1(h) + Ch(h, a, b) + K[i + 5] + W[i + 5];
-        t2 = e0(d) + Maj(d, e, f);    g += t1;    c = t1 + t2;
-        t1 = b + e1(g) + Ch(g, h, a) + K[i + 6] + W[i + 6];
-        t2 = e0(c) + Maj(c, d, e);    f += t1;    b = t1 + t2;
-        t1 = a + e1(f) + Ch(f, g, h) + K[i + 7] + W[i + 7];
-        t2 = e0(b) + Maj(b, c, d);    e += t1;    a = t1 + t2;
-    }
 
-    for ( ; i < 64; i += 8 )
-    {
-        t1 = h + e1(e) + Ch(e, f, g) + K[i + 0] + sha256_blend(W, i + 0);
-        t2 = e0(a) + Maj(a, b, c);    d += t1;    h = t1+t2;
-        t1 = g + e1(d) + Ch(d, e, f) + K[i + 1] + sha256_blend(W, i + 1);
-        t2 = e0(h) + Maj(h, a, b);    c += t1;    g = t1+t2;
-        t1 = f + e1(c) + Ch(c, d, e) + K[i + 2] + sha256_blend(W, i + 2);
-        t2 = e0(g) + Maj(g, h, a);    b += t1;    f = t1+t2;
-        t1 = e + e1(b) + Ch(b, c, d) + K[i + 3] + sha256_blend(W, i + 3);
-        t2 = e0(f) + Maj(f, g, h);    a += t1;    e = t1+t2;
-        t1 = d + e1(a) + Ch(a, b, c) + K[i + 4] + sha256_blend(W, i + 4);
-        t2 = e0(e) + Maj(e, f, g);    h += t1;    d = t1+t2;
-        t1 = c + e1(h) + Ch(h, a, b) + K[i + 5] + sha256_blend(W, i + 5);
-        t2 = e0(d) + Maj(d, e, f);    g += t1;    c = t1+t2;
-        t1 = b + e1(g) + Ch(g, h, a) + K[i + 6] + sha256_blend(W, i + 6);
-        t2 = e0(c) + Maj(c, d, e);    f += t1;    b = t1+t2;
-        t1 = a + e1(f) + Ch(f, g, h) + K[i + 7] + sha256_blend(W, i + 7);
-        t2 = e0(b) + Maj(b, c, d);    e += t1;    a = t1+t2;
+        t1 = a;  a = e;  e = t1;
+        t1 = b;  b = f;  f = t1;
+        t1 = c;  c = g;  g = t1;
+        t1 = d;  d = h;  h = t1;
     }
 
     state[0] += a; state[1] += b; state[2] += c; state[3] += d;
     state[4] += e; state[5] += f; state[6] += g; state[7] += h;
 }
 
-static void sha256_init(struct sha256_state *sctx)
+void sha256_init(struct sha256_state *sctx)
 {
     *sctx = (struct sha256_state){
         .state = {
@@ -152,19 +133,37 @@ static void sha256_init(struct sha256_state *sctx)
     };
 }
 
-static void sha256_once(struct sha256_state *sctx, const void *data, u32 len)
+/* Adds len bytes at data to the hash.  May be called any number of times. */
+void sha256_update(struct sha256_state *sctx, const void *data, u64 len)
 {
-    sctx->count = len;
+    unsigned int partial = sctx->count & 0x3f, n;
+
+    sctx->count += len;
+
+    if ( partial )
+    {
+        n = 64 - partial;
+        if ( n > len )
+            n = len;
+        memcpy(sctx->buf + partial, data, n);
+        if ( partial + n < 64 )
+            return;
+
+        sha256_transform(sctx->state, sctx->buf);
+        data += n;
+        len -= n;
+    }
+
     for ( ; len >= 64; data += 64, len -= 64 )
         sha256_transform(sctx->state, data);
 
     memcpy(sctx->buf, data, len);
 }
 
-static void sha256_final(struct sha256_state *sctx, void *_dst)
+void sha256_final(struct sha256_state *sctx, void *_dst)
 {
     u32 *dst = _dst;
-    u64 *count;
+    u64 count;
     unsigned int i, partial = sctx->count & 0x3f;
 
     /* Start padding */
@@ -180,9 +179,9 @@ static void sha256_final(struct sha256_state *sctx, void *_dst)
     /* Pad to 56 */
     memset(sctx->buf + partial, 0, 56 - partial);
 
-    /* Append the 64 bit count */
-    count = (void *)&sctx->buf[56];
-    *count = cpu_to_be64((u64)sctx->count << 3);
+    /* Append the 64 bit count, via memcpy() as buf[] is read as u32 */
+    count = cpu_to_be64((u64)sctx->count << 3);
+    memcpy(&sctx->buf[56], &count, sizeof(count));
     sha256_transform(sctx->state, sctx->buf);
 
     /* Store state in digest */
@@ -190,11 +189,11 @@ static void sha256_final(struct sha256_state *sctx, void *_dst)
         dst[i] = cpu_to_be32(sctx->state[i]);
 }
 
-void sha256sum(u8 hash[static SHA256_DIGEST_SIZE], const void *data, u32 len)
+void sha256sum(u8 hash[static SHA256_DIGEST_SIZE], const void *data, u64 len)
 {
     struct sha256_state sctx;
 
     sha256_init(&sctx);
-    sha256_once(&sctx, data, len);
+    sha256_update(&sctx, data, len);
     sha256_final(&sctx, hash);
 }
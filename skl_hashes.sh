@@ -0,0 +1,18 @@
+#!/bin/bash
+. util.sh
+
+# Emit the digests of the measured part of SKL (first SL_SIZE bytes, i.e. up
+# to sl_header.bootloader_data_offset) in a shell-sourceable KEY=VALUE format.
+# The measured part is constant for a given build, so bootloaders can use these
+# values for SKL_TAG_SKL_HASH instead of hashing the image on every boot.
+
+if [[ -z "$SL_SIZE" ]] || (( SL_SIZE == 0 )); then
+	>&2 echo "ERROR: can't read measured size of $SLB_FILE"
+	exit 1
+fi
+
+echo "# Hashes of the measured part of $(basename "$SLB_FILE")"
+echo "SKL_MEASURED_SIZE=$SL_SIZE"
+echo "SKL_SHA1=$(sha1_skl)"
+echo "SKL_SHA256=$(sha256_skl)"
+echo "SKL_SHA384=$(sha384_skl)"
@@ -1,22 +1,103 @@
+#include <defs.h>
 #include <types.h>
+#include <boot.h>
 
-void *(memcpy)(void *dst, const void *src, size_t count)
+/*
+ * rep movsb/stosb are quick at any size with FSRM, and once past their
+ * startup cost with ERMS.  Without ERMS, whole words are moved instead, and
+ * only the odd bytes one at a time.
+ */
+#define STRING_CAPS_KNOWN   (1 << 0)
+#define STRING_CAPS_ERMS    (1 << 1)
+#define STRING_CAPS_FSRM    (1 << 2)
+
+/* Below this, a plain loop beats rep movsb/stosb without FSRM */
+#define STRING_SHORT        64
+
+#ifdef __x86_64__
+#define REP_MOVS_WORD       "rep movsq"
+#define REP_STOS_WORD       "rep stosq"
+#else
+#define REP_MOVS_WORD       "rep movsl"
+#define REP_STOS_WORD       "rep stosl"
+#endif
+
+static unsigned int string_caps;
+
+static unsigned int get_string_caps(void)
+{
+    u32 eax, ebx, ecx, edx;
+
+    if ( string_caps )
+        return string_caps;
+
+    string_caps = STRING_CAPS_KNOWN;
+
+    cpuid(CPUID_MAX_STD_LEAF, 0, &eax, &ebx, &ecx, &edx);
+    if ( eax < CPUID_STD_FEATURES7 )
+        return string_caps;
+
+    cpuid(CPUID_STD_FEATURES7, 0, &eax, &ebx, &ecx, &edx);
+    if ( ebx & CPUID_7_EBX_ERMS )
+        string_caps |= STRING_CAPS_ERMS;
+    if ( edx & CPUID_7_EDX_FSRM )
+        string_caps |= STRING_CAPS_FSRM;
+
+    return string_caps;
+}
+
+void *(memcpy)(void *dst, const void *src, size_t n)
 {
+    unsigned int caps = get_string_caps();
     const char *s = src;
     char *d = dst;
+    size_t words;
+
+    if ( n < STRING_SHORT && !(caps & STRING_CAPS_FSRM) )
+    {
+        while ( n-- )
+            *d++ = *s++;
+
+        return dst;
+    }
 
-    while ( count-- )
-        *d++ = *s++;
+    if ( !(caps & STRING_CAPS_ERMS) )
+    {
+        words = n / sizeof(long);
+        n %= sizeof(long);
+        asm volatile(REP_MOVS_WORD
+                     : "+D" (d), "+S" (s), "+c" (words) : : "memory");
+    }
+
+    asm volatile("rep movsb" : "+D" (d), "+S" (s), "+c" (n) : : "memory");
 
     return dst;
 }
 
 void *(memset)(void *dst, int c, size_t n)
 {
+    unsigned int caps = get_string_caps();
     char *d = dst;
+    size_t words;
+
+    if ( n < STRING_SHORT && !(caps & STRING_CAPS_FSRM) )
+    {
+        while ( n-- )
+            *d++ = c;
+
+        return dst;
+    }
+
+    if ( !(caps & STRING_CAPS_ERMS) )
+    {
+        words = n / sizeof(long);
+        n %= sizeof(long);
+        asm volatile(REP_STOS_WORD
+                     : "+D" (d), "+c" (words)
+                     : "a" ((unsigned char)c * (~0UL / 0xff)) : "memory");
+    }
 
-    while ( n-- )
-        *d++ = c;
+    asm volatile("rep stosb" : "+D" (d), "+c" (n) : "a" (c) : "memory");
 
     return dst;
 }
@@ -0,0 +1,101 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <defs.h>
+#include <types.h>
+#include <errno-base.h>
+#include <boot.h>
+#include <string.h>
+#include <tags.h>
+
+/*
+ * Tags of each indexed type are chained in the order they appear.  Positions
+ * are 1-based, so that 0 ends a chain.
+ */
+static struct {
+    u8 first[SKL_TAG_INDEX_TYPES];
+    u8 last[SKL_TAG_INDEX_TYPES];
+    u8 next[SKL_MAX_TAGS];
+    u16 offset[SKL_MAX_TAGS];   /* From bootloader_data */
+} tag_index;
+
+int tags_index(void)
+{
+    struct skl_tag_hdr *t = (void *)&bootloader_data;
+    void *end = end_of_tags();
+    unsigned int n = 0;
+
+    memset(&tag_index, 0, sizeof(tag_index));
+
+    if ( t->type != SKL_TAG_TAGS_SIZE
+         || t->len != sizeof(struct skl_tag_tags_size)
+         || end > _p(_start + SLB_SIZE) )
+        return -EINVAL;
+
+    for ( ; ; t = _p(t) + t->len )
+    {
+        /* Truncated tags, and ones which would have us go round forever */
+        if ( _p(t + 1) > end || t->len < sizeof(*t) || _p(t) + t->len > end )
+            return -EINVAL;
+
+        /* Types from newer loaders are skipped, like they always were */
+        if ( t->type < SKL_TAG_INDEX_TYPES )
+        {
+            if ( n == SKL_MAX_TAGS )
+                return -EINVAL;
+
+            tag_index.offset[n] = _p(t) - _p(&bootloader_data);
+            if ( tag_index.last[t->type] )
+                tag_index.next[tag_index.last[t->type] - 1] = n + 1;
+            else
+                tag_index.first[t->type] = n + 1;
+            tag_index.last[t->type] = ++n;
+        }
+
+        if ( t->type == SKL_TAG_END )
+            return _p(t) + t->len == end ? 0 : -EINVAL;
+    }
+}
+
+void *next_of_type(void *t, u8 type)
+{
+    unsigned int offset = t - _p(&bootloader_data), i;
+
+    if ( type >= SKL_TAG_INDEX_TYPES )
+        return NULL;
+
+    for ( i = tag_index.first[type]; i; i = tag_index.next[i - 1] )
+        if ( tag_index.offset[i - 1] > offset )
+            return _p(&bootloader_data) + tag_index.offset[i - 1];
+
+    return NULL;
+}
+
+void *next_of_class(void *t, u8 c)
+{
+    void *found = NULL, *x;
+    unsigned int type;
+
+    /* The earliest of any of the types in the class */
+    for ( type = c; type < c + 0x10; type++ )
+    {
+        x = next_of_type(t, type);
+        if ( x && (!found || x < found) )
+            found = x;
+    }
+
+    return found;
+}
@@ -0,0 +1,161 @@
+/*
+ * acpi_find_table() starting from an RSDP given in SKL_TAG_ACPI_RSDP, with
+ * well formed and broken tables.  Without the tag, the RSDP is searched for
+ * in low memory, which isn't there on the host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+
+/* crt1.o already has _start, the SLB below stands in for the linked one. */
+#define _start skl_start
+
+#include "tags.c"
+#include "acpi.c"
+
+#define SIM_BOOTLOADER_DATA     0xf000
+#define STR(x)                  #x
+#define XSTR(x)                 STR(x)
+
+u8 sim_slb[SLB_SIZE];
+
+asm (".global skl_start, bootloader_data\n\t"
+     ".hidden skl_start, bootloader_data\n\t"
+     ".set skl_start, sim_slb\n\t"
+     ".set bootloader_data, sim_slb + " XSTR(SIM_BOOTLOADER_DATA));
+
+#define SIG_WANTED      ACPI_SIG('W', 'A', 'N', 'T')
+#define SIG_OTHER       ACPI_SIG('O', 'T', 'H', 'R')
+
+/* Firmware's tables, below 4G as acpi.c requires */
+static struct firmware {
+    struct acpi_rsdp rsdp;
+    struct {
+        struct acpi_table_header hdr;
+        u32 entry[2];
+    } __packed rsdt;
+    struct {
+        struct acpi_table_header hdr;
+        u64 entry[2];
+    } __packed xsdt;
+    struct acpi_table_header other, wanted;
+} *fw;
+
+static const struct test {
+    const char *name;
+    unsigned int revision;      /* Of the RSDP */
+    bool bad_rsdp, bad_xsdt, bad_wanted, high_rsdp;
+    bool found;
+} tests[] = {
+    { "ACPI 1.0, RSDT", .revision = 0, .found = true },
+    { "ACPI 2.0, XSDT", .revision = 2, .found = true },
+    { "ACPI 2.0, bad XSDT, RSDT", .revision = 2, .bad_xsdt = true,
+      .found = true },
+    { "Bad RSDP checksum", .revision = 2, .bad_rsdp = true },
+    { "Bad table checksum", .revision = 2, .bad_wanted = true },
+    { "RSDP above 4G", .revision = 2, .high_rsdp = true },
+};
+
+static u8 sum(const void *p, u32 len)
+{
+    const u8 *b = p;
+    u8 s = 0;
+
+    while ( len-- )
+        s += *b++;
+
+    return s;
+}
+
+static void table(struct acpi_table_header *t, u32 sig, u32 len, bool bad)
+{
+    t->signature = sig;
+    t->length = len;
+    t->checksum = 0;
+    t->checksum = -sum(t, len) + bad;
+}
+
+static void setup(const struct test *t)
+{
+    struct acpi_rsdp *rsdp = &fw->rsdp;
+    struct {
+        struct skl_tag_tags_size size;
+        struct skl_tag_acpi_rsdp rsdp;
+        struct skl_tag_hdr end;
+    } __packed tags = {
+        { { SKL_TAG_TAGS_SIZE, sizeof(tags.size) }, sizeof(tags) },
+        { { SKL_TAG_ACPI_RSDP, sizeof(tags.rsdp) },
+          t->high_rsdp ? 1ULL << 32 : _u(rsdp) },
+        { SKL_TAG_END, sizeof(tags.end) },
+    };
+
+    memset(fw, 0, sizeof(*fw));
+
+    fw->rsdt.entry[0] = fw->xsdt.entry[0] = _u(&fw->other);
+    fw->rsdt.entry[1] = fw->xsdt.entry[1] = _u(&fw->wanted);
+    table(&fw->other, SIG_OTHER, sizeof(fw->other), false);
+    table(&fw->wanted, SIG_WANTED, sizeof(fw->wanted), t->bad_wanted);
+    table(&fw->rsdt.hdr, ACPI_SIG('R', 'S', 'D', 'T'), sizeof(fw->rsdt),
+          false);
+    table(&fw->xsdt.hdr, ACPI_SIG('X', 'S', 'D', 'T'), sizeof(fw->xsdt),
+          t->bad_xsdt);
+
+    rsdp->signature = ACPI_SIG_RSDP;
+    rsdp->revision = t->revision;
+    rsdp->rsdt_address = _u(&fw->rsdt);
+    rsdp->length = sizeof(*rsdp);
+    rsdp->xsdt_address = _u(&fw->xsdt);
+    rsdp->checksum = -sum(rsdp, offsetof(struct acpi_rsdp, length)) +
+                     t->bad_rsdp;
+    rsdp->extended_checksum = -sum(rsdp, sizeof(*rsdp));
+
+    memcpy(sim_slb + SIM_BOOTLOADER_DATA, &tags, sizeof(tags));
+    /* Written through sim_slb, which the compiler can't tell is aliased */
+    barrier();
+}
+
+int main(void)
+{
+    bool fail = false;
+
+    fw = mmap(NULL, sizeof(*fw), PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if ( fw == MAP_FAILED || _u(fw) + sizeof(*fw) > 0x100000000ULL )
+    {
+        fprintf(stderr, "Can't allocate firmware tables below 4G\n");
+        return 1;
+    }
+
+    for ( unsigned int i = 0; i < ARRAY_SIZE(tests); ++i )
+    {
+        const struct test *t = &tests[i];
+        void *found, *other;
+        u32 len = 0;
+        bool t_fail;
+
+        setup(t);
+        if ( tags_index() )
+        {
+            printf("Fail: %s, bad tags\n", t->name);
+            fail = true;
+            continue;
+        }
+
+        found = acpi_find_table(SIG_WANTED, &len);
+        other = acpi_find_table(ACPI_SIG('N', 'O', 'N', 'E'), &len);
+        t_fail = found != (t->found ? &fw->wanted : NULL) || other != NULL ||
+                 len != (t->found ? sizeof(fw->wanted) : 0);
+
+        printf("%s: %s\n", t_fail ? "Fail" : "Ok", t->name);
+        fail |= t_fail;
+    }
+
+    if ( !fail )
+        printf("All ok\n");
+
+    return fail;
+}
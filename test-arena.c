@@ -0,0 +1,147 @@
+/*
+ * arena_init() picking the gap below .page_data or unused L2 tables, and
+ * allocations from it being aligned, freed in reverse order and never
+ * overrunning.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <setjmp.h>
+
+#include "arena.c"
+
+#define SIM_GAP                 0x140
+#define STR(x)                  #x
+#define XSTR(x)                 STR(x)
+
+u8 sim_gap[SIM_GAP] __aligned(ARENA_ALIGN);
+
+asm (".global _arena_start, _arena_end\n\t"
+     ".hidden _arena_start, _arena_end\n\t"
+     ".set _arena_start, sim_gap\n\t"
+     ".set _arena_end, sim_gap + " XSTR(SIM_GAP));
+
+u64 l2_identmap[4 * 512] __aligned(PAGE_SIZE), l3_identmap[512];
+
+static jmp_buf *die_jmp;
+
+void die(void)
+{
+    if ( die_jmp )
+        longjmp(*die_jmp, 1);
+    abort();
+}
+
+#define L2      1               /* L3 entry pointing at an L2 table */
+#define GB      _PAGE_PSE       /* L3 entry which is a 1G page */
+
+static const struct test {
+    const char *name;
+    u64 l3[4];
+    u8 *start;                  /* Where the arena is expected */
+    u32 size;
+} tests[] = {
+    {
+        "No 1G pages, the gap below .page_data",
+        .l3 = { L2, L2, L2, L2 },
+        .start = sim_gap, .size = SIM_GAP,
+    },
+    {
+        "SLB in the first GB, three L2 tables free",
+        .l3 = { L2, GB, GB, GB },
+        .start = (u8 *)&l2_identmap[512], .size = 3 * PAGE_SIZE,
+    },
+    {
+        "SLB in the second GB, longest run after it",
+        .l3 = { GB, L2, GB, GB },
+        .start = (u8 *)&l2_identmap[2 * 512], .size = 2 * PAGE_SIZE,
+    },
+    {
+        "SLB in the fourth GB, longest run before it",
+        .l3 = { GB, GB, GB, L2 },
+        .start = (u8 *)&l2_identmap[0], .size = 3 * PAGE_SIZE,
+    },
+    {
+        "One L2 table free, rather than the gap",
+        .l3 = { L2, L2, GB, L2 },
+        .start = (u8 *)&l2_identmap[2 * 512], .size = PAGE_SIZE,
+    },
+};
+
+static bool check(const struct test *t)
+{
+    u8 *a, *b, *c;
+    jmp_buf died;
+    bool fail = false;
+
+    memset(l3_identmap, 0, sizeof(l3_identmap));
+    memcpy(l3_identmap, t->l3, sizeof(t->l3));
+
+    arena_init();
+
+    if ( arena_next != t->start || arena_limit != t->start + t->size )
+    {
+        printf("  Arena %p-%p, expected %p-%p\n", arena_next, arena_limit,
+               t->start, t->start + t->size);
+        return true;
+    }
+
+    a = arena_alloc(1);
+    b = arena_alloc(ARENA_ALIGN + 1);
+    c = arena_alloc(0);
+    if ( a != t->start || b != a + ARENA_ALIGN || c != b + 2 * ARENA_ALIGN )
+    {
+        printf("  Allocated %p, %p, %p\n", a, b, c);
+        fail = true;
+    }
+
+    /* Freeing b frees c too, and the next allocation reuses b */
+    arena_free(b);
+    if ( arena_alloc(16) != b )
+    {
+        printf("  Space not reused after free\n");
+        fail = true;
+    }
+
+    /* All of what's left is fine, a byte more isn't */
+    arena_free(a);
+    if ( arena_alloc(t->size) != a )
+    {
+        printf("  Couldn't allocate all %#x bytes\n", t->size);
+        fail = true;
+    }
+
+    arena_free(a);
+    die_jmp = &died;
+    if ( !setjmp(died) )
+    {
+        arena_alloc(t->size + 1);
+        printf("  Allocated past the end\n");
+        fail = true;
+    }
+    die_jmp = NULL;
+
+    return fail;
+}
+
+int main(void)
+{
+    bool fail = false;
+
+    for ( unsigned int i = 0; i < ARRAY_SIZE(tests); ++i )
+    {
+        const struct test *t = &tests[i];
+        bool t_fail = check(t);
+
+        printf("%s: %s\n", t_fail ? "Fail" : "Ok", t->name);
+        fail |= t_fail;
+    }
+
+    if ( !fail )
+        printf("All ok\n");
+
+    return fail;
+}
@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "test-platform.h"
+
+#include "pci.c"
+#include "dev.c"
+#include "iommu.c"
+
+#define ALL     (~0U)
+
+static const struct test {
+    const char *name;
+    bool ecam, dev, ivrs;
+    unsigned int nr_iommus;     /* On the platform */
+    unsigned int found;         /* Expected from iommu_locate() */
+    /* Bitmaps of IOMMUs */
+    unsigned int no_iasup, fw_disabled, hang;
+    /* If set, what the last IVHD says instead of the last IOMMU */
+    u16 forged_id, forged_cap;
+    int ret;                    /* Expected from iommu_flush_wait() */
+} tests[] = {
+    {
+        "Fam17h, CF8, one IOMMU",
+        .nr_iommus = 1, .found = 1,
+    },
+    {
+        "Fam17h, ECAM, one IOMMU",
+        .ecam = true, .nr_iommus = 1, .found = 1,
+    },
+    {
+        "Fam17h, ECAM, IVRS with three IOMMUs",
+        .ecam = true, .ivrs = true, .nr_iommus = 3, .found = 3,
+    },
+    {
+        "Fam17h, second IOMMU not in IVRS",
+        .nr_iommus = 2, .found = 1,
+    },
+    {
+        "DEV, one IOMMU without IASup",
+        .dev = true, .nr_iommus = 1, .found = 1, .no_iasup = ALL,
+    },
+    {
+        "Fam17h, IVRS, second IOMMU without IASup",
+        .ivrs = true, .nr_iommus = 2, .found = 2, .no_iasup = 1U << 1,
+    },
+    {
+        "Fam17h, IVRS, no IOMMU with IASup",
+        .ivrs = true, .nr_iommus = 3, .found = 3, .no_iasup = ALL,
+    },
+    {
+        "Fam17h, IVRS, second IOMMU disabled by firmware",
+        .ivrs = true, .nr_iommus = 2, .found = 2, .fw_disabled = 1U << 1,
+    },
+    {
+        "Fam17h, IVRS pointing past the IOMMU capability",
+        .ivrs = true, .nr_iommus = 2, .found = 1,
+        .forged_id = 0x40 << 8 | PCI_DEVFN(IOMMU_PCI_DEVICE,
+                                           IOMMU_PCI_FUNCTION),
+        .forged_cap = 0x44,
+    },
+    {
+        "DEV, IVRS pointing at the DEV capability",
+        .dev = true, .ivrs = true, .nr_iommus = 2, .found = 1,
+        .forged_id = PCI_DEVFN(DEV_PCI_DEVICE, DEV_PCI_FUNCTION),
+        .forged_cap = PLAT_DEV_CAP,
+    },
+    {
+        "Fam17h, IOMMU disabled by firmware",
+        .nr_iommus = 1, .found = 1, .fw_disabled = ALL, .ret = -ENODEV,
+    },
+    {
+        "Fam17h, no IOMMU",
+        .ret = -ENODEV,
+    },
+    {
+        "Fam17h, IOMMU never completes",
+        .nr_iommus = 1, .found = 1, .hang = ALL, .ret = -EBUSY,
+    },
+};
+
+/*
+ * Same ordering as iommu_setup() in main.c, minus TEST_DMA, and waiting for
+ * the flush straight away rather than after TPM bring-up.
+ */
+static int setup(const struct test *t, bool *fail)
+{
+    u32 nr, failed;
+
+    pci_init();
+    nr = iommu_locate();
+    if ( nr != t->found )
+    {
+        printf("  Found %u IOMMUs, expected %u\n", nr, t->found);
+        *fail = true;
+    }
+
+    if ( nr == 0 || (failed = iommu_load_device_table()) == nr )
+        return -ENODEV;
+
+    iommu_fail_safe();
+    disable_memory_protection();
+    iommu_load_device_table();
+    iommu_flush_submit();
+
+    return iommu_flush_wait();
+}
+
+#define CHECK(cond, ...)                        \
+    do {                                        \
+        if ( !(cond) )                          \
+        {                                       \
+            printf("  IOMMU %u: ", i);          \
+            printf(__VA_ARGS__);                \
+            printf("\n");                       \
+            fail = true;                        \
+        }                                       \
+    } while ( 0 )
+
+static bool check_iommus(const struct test *t)
+{
+    const u64 ctrl = IOMMU_CR_IommuEn | IOMMU_CR_CmdBufEn;
+    bool fail = false;
+    unsigned int i, devid;
+
+    for ( i = 0; i < t->found; i++ )
+    {
+        const struct model_iommu *m = &plat.iommu[i];
+        const u64 *regs = m->regs;
+
+        if ( !m->fw_enabled )
+        {
+            CHECK(regs[IOMMU_MMIO_CONTROL_REGISTER] == 0, "programmed");
+            continue;
+        }
+
+        CHECK((regs[IOMMU_MMIO_CONTROL_REGISTER] & ctrl) == ctrl,
+              "control %#"PRIx64, regs[IOMMU_MMIO_CONTROL_REGISTER]);
+        CHECK(regs[IOMMU_MMIO_DEVICE_TABLE_BA] == (_u(device_table) | 1),
+              "device table %#"PRIx64, regs[IOMMU_MMIO_DEVICE_TABLE_BA]);
+        CHECK(!(regs[IOMMU_MMIO_CONTROL_REGISTER] & IOMMU_CR_EventLogEn),
+              "event log enabled");
+        CHECK(m->hw_errors >= 1 || m->hang,
+              "first flush didn't hit SLB protection");
+        CHECK(m->illegal_cmds == 0, "%u illegal commands", m->illegal_cmds);
+
+        if ( t->ret != 0 )
+            continue;
+
+        CHECK((regs[IOMMU_MMIO_COMMAND_BUF_BA] & ~0xfffULL) ==
+              ((_u(command_buf) & ~0xfff) | (0x9ULL << 56)),
+              "command buffer %#"PRIx64, regs[IOMMU_MMIO_COMMAND_BUF_BA]);
+        CHECK(m->completions == 1, "%u completions", m->completions);
+
+        for ( devid = 0; devid < ARRAY_SIZE(device_table); devid++ )
+            if ( !m->dte_inv[devid] )
+                break;
+        CHECK(devid == ARRAY_SIZE(device_table), "DTE %04x not invalidated",
+              devid);
+    }
+
+    for ( i = 0; i < ARRAY_SIZE(device_table); i++ )
+        if ( device_table[i].a != (IOMMU_DTE_Q0_V | IOMMU_DTE_Q0_TV) )
+        {
+            printf("  DTE %#x not blocking\n", i);
+            fail = true;
+        }
+
+    return fail;
+}
+
+int main(void)
+{
+    bool fail = false;
+
+    for ( unsigned int i = 0; i < ARRAY_SIZE(tests); ++i )
+    {
+        const struct test *t = &tests[i];
+        bool t_fail = false;
+        int ret;
+
+        plat_reset(t->ecam, t->dev, t->ivrs, t->nr_iommus);
+        for ( unsigned int j = 0; j < t->nr_iommus; j++ )
+        {
+            plat.iommu[j].iasup = !(t->no_iasup & (1U << j));
+            plat.iommu[j].fw_enabled = !(t->fw_disabled & (1U << j));
+            plat.iommu[j].hang = t->hang & (1U << j);
+        }
+        if ( t->forged_cap )
+        {
+            plat.ivrs_table.ivhd[t->nr_iommus - 1].device_id = t->forged_id;
+            plat.ivrs_table.ivhd[t->nr_iommus - 1].capability_offset =
+                t->forged_cap;
+        }
+
+        ret = setup(t, &t_fail);
+
+        if ( ret != t->ret )
+        {
+            printf("  Got %d, expected %d\n", ret, t->ret);
+            t_fail = true;
+        }
+
+        if ( ret != -ENODEV && plat_slb_protected() )
+        {
+            printf("  SLB protection still enabled\n");
+            t_fail = true;
+        }
+
+        t_fail |= check_iommus(t);
+
+        printf("%s: %s", t_fail ? "Fail" : "Ok", t->name);
+        if ( ret == 0 )
+            printf(", flush latency %"PRIu64" ticks", iommu_flush_latency);
+        printf("\n");
+
+        fail |= t_fail;
+    }
+
+    if ( !fail )
+        printf("All ok\n");
+
+    return fail;
+}
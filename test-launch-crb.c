@@ -0,0 +1,56 @@
+/*
+ * test-launch, built as skl is with TPM_INTF=crb TPM_FAMILY=2 PCI=ecam.  The
+ * TPM2.0 CRB launches go through the direct calls, and the TIS ones have to
+ * be refused.  On top of those, the move from locality 0 to 2 is checked on
+ * its own.
+ */
+
+#define CONFIG_TPM_CRB
+#define CONFIG_TPM20
+#define CONFIG_PCI_ECAM
+
+#include <stdbool.h>
+
+static bool crb_locality_switch(void);
+#define LAUNCH_EXTRA_TESTS crb_locality_switch
+
+#include "test-launch.c"
+
+/*
+ * enable_tpm() only asks the TPM to get ready, at locality 0, and skl_main()
+ * moves to locality 2 before waiting for it.  The wait has to end with the
+ * TPM ready for locality 2, which every command after it comes from.
+ */
+static bool crb_locality_switch(void)
+{
+    const struct tpm_flavour *f = &tpms[ARRAY_SIZE(tpms) - 1];
+    u8 digest[SHA256_DIGEST_SIZE] = { 0x5a };
+    bool fail = false;
+    struct tpm *t;
+
+    plat_reset(true, false, false, 1);
+    model_tpm_reset(f->family, f->intf, skl_sha1, skl_sha256);
+    memset(&tpm, 0, sizeof(tpm));
+    memset(&tpm_buff, 0, sizeof(tpm_buff));
+    crb_locality = TPM_NO_LOCALITY;
+
+    t = enable_tpm();
+    if ( !t )
+    {
+        printf("Fail: %s, locality 0 to 2: not enabled\n", f->name);
+        return true;
+    }
+
+    CHECK(tpm_request_locality(t, 2) == 2, "Locality 2 not granted");
+    CHECK(tpm_wait_ready(t) == 0, "Not ready by TSC %"PRIu64, plat.tsc);
+    CHECK(tpm_model.state == TPM_STATE_READY && tpm_model.ready_loc == 2,
+          "Ready for locality %d, expected 2", tpm_model.ready_loc);
+    CHECK(tpm_extend_pcr(t, 18, TPM_ALG_SHA256, digest) == 0 &&
+          tpm_model.commands == 1 && tpm_model.bad_commands == 0,
+          "PCR18 extend from locality 2 failed");
+
+    printf("%s: %s, locality 0 to 2: ready at TSC %"PRIu64"\n",
+           fail ? "Fail" : "Ok", f->name, plat.tsc);
+
+    return fail;
+}
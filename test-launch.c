@@ -0,0 +1,1386 @@
+/*
+ * End-to-end launch on the host: the real skl_main(), with pci.c, dev.c,
+ * iommu.c, event_log.c and tpmlib underneath, against the platform model in
+ * test-platform.h and the TPM model in test-tpm.h.
+ *
+ * Every boot protocol is launched with every TPM flavour, with and without
+ * aggregating and Merkle trees.  Builds for one kind of TPM, as
+ * test-launch-crb, have to reboot on the others instead.  Each launch checks
+ * what skl_main() hands back, that the event log replays to the PCR values
+ * in the TPM and that the events measure what they claim to, and reports:
+ *
+ *  - the simulated launch time, i.e. TSC ticks at 1GHz, with a fixed cost per
+ *    hashed block on top of the platform's costs,
+ *  - the bytes hashed,
+ *  - the TPM commands issued,
+ *  - the event log bytes written.
+ *
+ * Payloads are made up, unless real ones are given:
+ *
+ *   ./test-launch [--linux bzImage] [--mb2 xen module...] [--simple file]
+ *
+ * A bzImage must have the Secure Launch MLE header.  Multiboot2 kernels and
+ * modules are loaded flat, as if they were already relocated.  The made up
+ * Linux initrd, Simple64 payload and one setup_indirect region are above 4G,
+ * and every payload is also launched on a CPU without 1G pages, which can't
+ * reach them.  One more launch has an IOMMU which never completes the flush,
+ * and one more a multiboot2 kernel with 64bit ELF sections.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* crt1.o already has _start, the SLB below stands in for the linked one. */
+#define _start skl_start
+
+/* As built with MERKLE=y, so SKL_MEASURE_MERKLE is honoured */
+#define CONFIG_MERKLE
+
+#include "test-platform.h"
+
+#include "pci.c"
+#include "dev.c"
+#include "iommu.c"
+#include "sha1sum.c"
+#include "sha256.c"
+
+#include "test-tpm.h"
+
+/* tpmlib, built as with CFLAGS_TPMLIB */
+#include <errno-base.h>
+#define EBADRQC EINVAL
+#define locality tis_locality
+#include "tpmlib/tis.c"
+#undef locality
+#define locality crb_locality
+#include "tpmlib/crb.c"
+#undef locality
+#include "tpmlib/tpm.c"
+#include "tpmlib/tpm1_cmds.c"
+#include "tpmlib/tpm2_cmds.c"
+#include "tpmlib/tpm2_auth.c"
+#include "tpmlib/tpm_buff.c"
+#include "tpmlib/tpmio.c"
+
+#include "event_log.c"
+#include "digest_table.c"
+#include "tags.c"
+#include "paging.c"
+#include "arena.c"
+
+/* Rough cost of the -Os, no SSE hashing code, in TSC ticks per 64 bytes */
+#define TICKS_SHA1_BLOCK        500
+#define TICKS_SHA256_BLOCK      1000
+
+static u64 bytes_hashed;
+static u64 bytes_unflushed;     /* Hashed before the IOMMU flush completed */
+
+static void count_hashed(u64 len)
+{
+    bytes_hashed += len;
+    if ( flush_state != FLUSH_DONE )
+        bytes_unflushed += len;
+}
+
+static void counted_sha1sum(u8 hash[static SHA1_DIGEST_SIZE], const void *ptr,
+                            u64 len)
+{
+    sha1sum(hash, ptr, len);
+    count_hashed(len);
+    plat_tick((len / 64 + 1) * TICKS_SHA1_BLOCK);
+}
+
+static void counted_sha256sum(u8 hash[static SHA256_DIGEST_SIZE],
+                              const void *ptr, u64 len)
+{
+    sha256sum(hash, ptr, len);
+    count_hashed(len);
+    plat_tick((len / 64 + 1) * TICKS_SHA256_BLOCK);
+}
+
+static void counted_sha1_update(SHA1_CONTEXT *hd, const void *data, u64 len)
+{
+    sha1_update(hd, data, len);
+    count_hashed(len);
+    plat_tick((len / 64) * TICKS_SHA1_BLOCK);
+}
+
+static void counted_sha256_update(struct sha256_state *sctx, const void *data,
+                                  u64 len)
+{
+    sha256_update(sctx, data, len);
+    count_hashed(len);
+    plat_tick((len / 64) * TICKS_SHA256_BLOCK);
+}
+
+#define sha1sum counted_sha1sum
+#define sha256sum counted_sha256sum
+#define sha1_update counted_sha1_update
+#define sha256_update counted_sha256_update
+#include "merkle.c"
+#include "main.c"
+#undef sha1sum
+#undef sha256sum
+#undef sha1_update
+#undef sha256_update
+
+/*
+ * The SLB.  The measured part is left zeroed, bootloader_data goes where the
+ * linker would put it.
+ */
+#define SIM_BOOTLOADER_DATA     0xe000
+#define STR(x)                  #x
+#define XSTR(x)                 STR(x)
+
+u8 sim_slb[SLB_SIZE] __aligned(PAGE_SIZE);
+
+asm (".global skl_start, bootloader_data\n\t"
+     ".hidden skl_start, bootloader_data\n\t"
+     ".set skl_start, sim_slb\n\t"
+     ".set bootloader_data, sim_slb + " XSTR(SIM_BOOTLOADER_DATA));
+
+/* The gap below .page_data, as small as link.lds may leave it */
+u8 sim_gap[ARENA_MIN] __aligned(ARENA_ALIGN);
+
+asm (".global _arena_start, _arena_end\n\t"
+     ".hidden _arena_start, _arena_end\n\t"
+     ".set _arena_start, sim_gap\n\t"
+     ".set _arena_end, sim_gap + " XSTR(ARENA_MIN));
+
+volatile u32 skl_stack_canary = STACK_CANARY;
+
+/*
+ * Only what map_gigabytes(), map_phys() and arena_init() look at.  L3[0..3]
+ * start out pointing at the L2 tables, as head.S leaves them.
+ */
+u64 l2_identmap[4 * 512], l3_identmap[512];
+
+#define L3_TO_L2(i)     (_u(&l2_identmap[(i) * 512]) + _PAGE_AD + _PAGE_RW + \
+                         _PAGE_PRESENT)
+#define L3_1G(i)        (((u64)(i) << L3_PT_SHIFT) + _PAGE_PSE + _PAGE_AD + \
+                         _PAGE_RW + _PAGE_PRESENT)
+
+#define EVTLOG_SIZE             0x10000
+#define EVTLOG_JUNK             0xa5        /* What the log has before SKL */
+#define MAX_MEASUREMENTS        16
+#define DIGEST_TABLE_SIZE       PAGE_SIZE
+
+struct measurement {
+    unsigned int pcr;
+    const void *data;
+    u32 size;
+    bool in_pieces;             /* So not in the digest table */
+    bool tree;                  /* Measured as a tree with SKL_MEASURE_MERKLE */
+};
+
+struct payload {
+    const char *name;
+    u8 tag[32];                 /* Boot tag, copied into bootloader_data */
+    bool evtlog64;              /* Pass the event log with SKL_TAG_EVENT_LOG64 */
+    u32 protocol;               /* boot_protocol expected afterwards */
+    asm_return_t ret;           /* Expected from skl_main() */
+
+    /* In order, after bootloader_data itself */
+    struct measurement m[MAX_MEASUREMENTS];
+    unsigned int nr_m;
+};
+
+static const struct tpm_flavour {
+    const char *name;
+    enum tpm_family family;
+    enum tpm_hw_intf intf;
+} tpms[] = {
+    { "TPM1.2 TIS", TPM12, TPM_TIS },
+    { "TPM2.0 TIS", TPM20, TPM_TIS },
+    { "TPM2.0 CRB", TPM20, TPM_CRB },
+};
+
+/* Guest memory below 4G, for anything the 32bit tags or fields point at. */
+static void *guest_alloc(size_t size)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+    if ( p == MAP_FAILED || _u(p) + size > 0x100000000ULL )
+    {
+        fprintf(stderr, "Can't allocate %zu bytes of guest memory\n", size);
+        exit(1);
+    }
+
+    return p;
+}
+
+/*
+ * Guest memory above 4G, for what can be passed with 64bit addresses.  It
+ * starts 1M short of a 1G boundary so allocations straddle it, and needs two
+ * L3 entries to map.
+ */
+#define HIGH_BASE               (0x800000000ULL + GIGABYTE - (1 << 20))
+#define HIGH_SIZE               (64 << 20)
+
+static void *high_alloc(size_t size)
+{
+    static u64 next = HIGH_BASE;
+    void *p;
+
+    if ( next == HIGH_BASE )
+    {
+        p = mmap(_p(HIGH_BASE), HIGH_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE |
+                 MAP_NORESERVE, -1, 0);
+        if ( p != _p(HIGH_BASE) )
+        {
+            fprintf(stderr, "Can't map guest memory at %#llx\n", HIGH_BASE);
+            exit(1);
+        }
+    }
+
+    if ( next + size > HIGH_BASE + HIGH_SIZE )
+    {
+        fprintf(stderr, "Can't allocate %zu bytes of high guest memory\n",
+                size);
+        exit(1);
+    }
+
+    p = _p(next);
+    next = PAGE_UP(next + size);
+
+    return p;
+}
+
+/* Deterministic junk, standing in for code */
+static void fill(void *p, size_t size, u32 seed)
+{
+    u8 *b = p;
+
+    while ( size-- )
+    {
+        seed = seed * 1103515245 + 12345;
+        *b++ = seed >> 16;
+    }
+}
+
+static void *load_file(const char *path, u32 *size)
+{
+    struct stat st;
+    FILE *f = fopen(path, "rb");
+    void *p;
+
+    if ( !f || fstat(fileno(f), &st) || st.st_size > 0x40000000 )
+    {
+        fprintf(stderr, "Can't load '%s'\n", path);
+        exit(1);
+    }
+
+    *size = st.st_size;
+    p = guest_alloc(*size + 1);
+    if ( fread(p, 1, *size, f) != *size )
+    {
+        fprintf(stderr, "Can't read '%s'\n", path);
+        exit(1);
+    }
+    fclose(f);
+
+    return p;
+}
+
+static void add_measurement(struct payload *p, unsigned int pcr,
+                            const void *data, u32 size)
+{
+    p->m[p->nr_m++] = (struct measurement){ pcr, data, size };
+}
+
+/*
+ * Linux: the image is "loaded" where it lies.  The zero page gets the setup
+ * header, with code32_start pointing at the protected mode part, and the
+ * initrd (if any) and command line.
+ */
+#define SETUP_HDR       0x1f1
+#define LINUX_CMDLINE   "console=ttyS0,115200 earlyprintk=serial rd.shell"
+
+static void linux_payload(struct payload *p, u8 *image, u32 size,
+                          void *initrd, u32 initrd_size)
+{
+    struct boot_params *bp = guest_alloc(PAGE_SIZE);
+    struct skl_tag_boot_linux *tag = (void *)p->tag;
+    char *cmdline = guest_alloc(PAGE_SIZE);
+    u32 setup_size = ((image[SETUP_HDR] ?: 4) + 1) * 512;
+    u32 hdr_end = 0x202 + image[0x201];
+
+    if ( size < setup_size || hdr_end > PAGE_SIZE )
+    {
+        fprintf(stderr, "Not a bzImage\n");
+        exit(1);
+    }
+
+    memcpy(_p(bp) + SETUP_HDR, image + SETUP_HDR, hdr_end - SETUP_HDR);
+    bp->code32_start = _u(image) + setup_size;
+
+    *tag = (struct skl_tag_boot_linux){
+        .hdr = { SKL_TAG_BOOT_LINUX, sizeof(*tag) },
+        .zero_page = _u(bp),
+    };
+
+    p->protocol = LINUX_BOOT;
+    p->ret = (asm_return_t){ NULL, bp };
+    if ( bp->version >= 0x020f &&
+         bp->kern_info_offset + sizeof(struct kernel_info) < size - setup_size )
+    {
+        struct kernel_info *ki = _p(bp->code32_start + bp->kern_info_offset);
+        struct mle_header *mh = _p(bp->code32_start + ki->mle_header_offset);
+
+        if ( ki->mle_header_offset + sizeof(*mh) < size - setup_size )
+            p->ret.pm_kernel_entry = _p(bp->code32_start + mh->sl_stub_entry);
+    }
+
+    add_measurement(p, 17, _p(bp->code32_start), bp->syssize << 4);
+
+    if ( initrd )
+    {
+        bp->ramdisk_image = _u(initrd);
+        bp->ext_ramdisk_image = (u64)_u(initrd) >> 32;
+        bp->ramdisk_size = initrd_size;
+        add_measurement(p, 17, initrd, initrd_size);
+    }
+
+    strcpy(cmdline, LINUX_CMDLINE);
+    bp->cmd_line_ptr = _u(cmdline);
+    add_measurement(p, 18, cmdline, strlen(cmdline));
+}
+
+/* Something that looks enough like a bzImage with an MLE header */
+static void make_linux(struct payload *p, u32 size, u32 initrd_size)
+{
+    u32 setup_size = 5 * 512;
+    u8 *image = guest_alloc(setup_size + size);
+    u8 *initrd = high_alloc(initrd_size);
+    struct boot_params *hdr = (void *)image;
+    struct kernel_info *ki = _p(image + setup_size + 0x100);
+    struct mle_header *mh = _p(image + setup_size + 0x200);
+
+    fill(image, setup_size + size, size);
+    fill(initrd, initrd_size, 4);
+
+    memset(image + SETUP_HDR, 0, 0x80);
+    image[SETUP_HDR] = 4;
+    image[0x201] = 0x6a;
+    hdr->syssize = size >> 4;
+    hdr->version = 0x020f;
+    hdr->cmdline_size = 2047;
+    hdr->payload_offset = 0x4000;
+    hdr->payload_length = size - 0x8000;
+    hdr->kern_info_offset = 0x100;
+
+    *ki = (struct kernel_info){
+        .header = KERNEL_INFO_HEADER,
+        .size = sizeof(*ki),
+        .size_total = sizeof(*ki),
+        .mle_header_offset = 0x200,
+    };
+    *mh = (struct mle_header){
+        .uuid = { MLE_UUID0, MLE_UUID1, MLE_UUID2, MLE_UUID3 },
+        .size = 0x34,
+        .version = 0x00020002,
+        .sl_stub_entry = 0x1000,
+    };
+
+    linux_payload(p, image, setup_size + size, initrd, initrd_size);
+}
+
+/*
+ * Multiboot2: the MBI has what GRUB gives Xen, i.e. modules, then ELF
+ * sections, with the kernel as the only PROGBITS section.
+ */
+/*
+ * Sections of the multiboot2 kernel, linked at KERNEL_LINK and loaded
+ * elsewhere.  Padding between .rodata and .data, and .bss, aren't measured.
+ */
+#define KERNEL_LINK             0x200000
+#define KERNEL_DATA_GAP         0x1000
+
+static const Elf32_Shdr kernel_sections[] = {
+    { .sh_type = SHT_NULL },
+    { .sh_type = SHT_PROGBITS, .sh_flags = SHF_ALLOC,   /* .text */
+      .sh_addr = KERNEL_LINK, .sh_size = 512 << 10 },
+    { .sh_type = SHT_PROGBITS, .sh_flags = SHF_ALLOC,   /* .rodata */
+      .sh_addr = KERNEL_LINK + (512 << 10), .sh_size = 128 << 10 },
+    { .sh_type = SHT_PROGBITS, .sh_flags = SHF_ALLOC,   /* .data */
+      .sh_addr = KERNEL_LINK + (640 << 10) + KERNEL_DATA_GAP,
+      .sh_size = 256 << 10 },
+    { .sh_type = SHT_NOBITS, .sh_flags = SHF_ALLOC,     /* .bss */
+      .sh_addr = KERNEL_LINK + (896 << 10) + KERNEL_DATA_GAP,
+      .sh_size = 64 << 10 },
+    { .sh_type = SHT_SYMTAB, .sh_size = 32 << 10 },     /* .symtab */
+};
+
+/*
+ * The kernel is loaded with its first section at kernel, sections[] describe
+ * it as linked.  The tag has them as Elf64_Shdr if elf64.
+ */
+static void mb2_payload(struct payload *p, void *kernel,
+                        const Elf32_Shdr *sections, unsigned int nr_sections,
+                        bool elf64, unsigned int nr_mods, void **mods,
+                        u32 *mod_sizes, const char **names)
+{
+    struct skl_tag_boot_mb2 *tag = (void *)p->tag;
+    u8 *mbi = guest_alloc(PAGE_SIZE), *pos = mbi + 8;
+    struct multiboot_tag_load_base_addr *ba = (void *)pos;
+    struct multiboot_tag_elf_sections *es;
+    u8 *measured = NULL;
+    u32 size = 0, first = 0;
+    unsigned int i;
+
+    *ba = (struct multiboot_tag_load_base_addr){
+        MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR, sizeof(*ba), _u(kernel),
+    };
+    pos = _p(multiboot_next_tag(_p(ba)));
+
+    for ( i = 0; i < nr_mods; i++ )
+    {
+        struct multiboot_tag_module *mod = (void *)pos;
+
+        mod->type = MULTIBOOT_TAG_TYPE_MODULE;
+        mod->size = sizeof(*mod) + strlen(names[i]) + 1;
+        mod->mod_start = _u(mods[i]);
+        mod->mod_end = _u(mods[i]) + mod_sizes[i];
+        strcpy(mod->cmdline, names[i]);
+        pos = _p(multiboot_next_tag(_p(mod)));
+    }
+
+    /* After the modules, where GRUB2 puts it */
+    es = (void *)pos;
+    es->type = MULTIBOOT_TAG_TYPE_ELF_SECTIONS;
+    es->entsize = elf64 ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr);
+    es->size = sizeof(*es) + nr_sections * es->entsize;
+    es->num = nr_sections;
+    for ( i = 0; i < nr_sections; i++ )
+    {
+        const Elf32_Shdr *sh = &sections[i];
+        Elf64_Shdr sh64 = {
+            .sh_type = sh->sh_type, .sh_flags = sh->sh_flags,
+            .sh_addr = sh->sh_addr, .sh_size = sh->sh_size,
+        };
+
+        if ( elf64 )
+            memcpy(&es->sections[i * sizeof(sh64)], &sh64, sizeof(sh64));
+        else
+            memcpy(&es->sections[i * sizeof(*sh)], sh, sizeof(*sh));
+    }
+    pos = _p(multiboot_next_tag(_p(es)));
+
+    ((struct multiboot_tag *)pos)->type = MULTIBOOT_TAG_TYPE_END;
+    ((struct multiboot_tag *)pos)->size = 8;
+    pos += 8;
+
+    /* total_size, reserved */
+    ((u32 *)mbi)[0] = pos - mbi;
+    ((u32 *)mbi)[1] = 0;
+
+    *tag = (struct skl_tag_boot_mb2){
+        .hdr = { SKL_TAG_BOOT_MB2, sizeof(*tag) },
+        .mbi = _u(mbi),
+    };
+
+    p->protocol = MULTIBOOT2;
+    p->ret = (asm_return_t){ kernel, mbi };
+
+    /* What the kernel's event covers, the loaded sections back to back */
+    for ( i = 0; i < nr_sections; i++ )
+    {
+        const Elf32_Shdr *sh = &sections[i];
+
+        if ( !(sh->sh_flags & SHF_ALLOC) || sh->sh_type == SHT_NOBITS )
+            continue;
+        if ( !measured )
+            first = sh->sh_addr;
+        measured = realloc(measured, size + sh->sh_size);
+        memcpy(measured + size, kernel + (sh->sh_addr - first), sh->sh_size);
+        size += sh->sh_size;
+    }
+
+    add_measurement(p, 18, mbi, pos - mbi);
+    for ( i = 0; i < nr_mods; i++ )
+    {
+        add_measurement(p, 17, mods[i], mod_sizes[i]);
+        p->m[p->nr_m - 1].tree = true;
+    }
+    add_measurement(p, 17, measured, size);
+    p->m[p->nr_m - 1].in_pieces = true;
+}
+
+static void make_mb2(struct payload *p, bool elf64)
+{
+    static const char *names[] = { "vmlinuz console=hvc0", "initrd.img" };
+    /* Not a whole number of Merkle chunks, nor of pages */
+    u32 sizes[] = { 8 << 20, (16 << 20) + PAGE_SIZE + 7 };
+    void *mods[ARRAY_SIZE(sizes)];
+    void *xen = guest_alloc(1 << 20);
+    unsigned int i;
+
+    fill(xen, 1 << 20, 1);
+    for ( i = 0; i < ARRAY_SIZE(sizes); i++ )
+    {
+        mods[i] = guest_alloc(sizes[i]);
+        fill(mods[i], sizes[i], i + 2);
+    }
+
+    mb2_payload(p, xen, kernel_sections, ARRAY_SIZE(kernel_sections), elf64,
+                ARRAY_SIZE(sizes), mods, sizes, names);
+}
+
+static void simple_payload(struct payload *p, void *base, u32 size)
+{
+    struct skl_tag_boot_simple_payload *tag = (void *)p->tag;
+
+    *tag = (struct skl_tag_boot_simple_payload){
+        .hdr = { SKL_TAG_BOOT_SIMPLE, sizeof(*tag) },
+        .base = _u(base),
+        .size = size,
+        .entry = _u(base),
+        .arg = 0x1234,
+    };
+
+    p->protocol = SIMPLE_PAYLOAD;
+    p->ret = (asm_return_t){ base, _p(0x1234) };
+
+    add_measurement(p, 17, base, size);
+    p->m[p->nr_m - 1].tree = true;
+}
+
+static void make_simple(struct payload *p)
+{
+    void *base = guest_alloc(64 << 10);
+
+    fill(base, 64 << 10, 3);
+    simple_payload(p, base, 64 << 10);
+}
+
+/*
+ * A payload above 4G, which has its own 32bit entry point, as does e.g. a
+ * live image with a small loader.  The event log is passed the 64bit way too.
+ */
+static void make_simple64(struct payload *p)
+{
+    struct skl_tag_boot_simple_payload64 *tag = (void *)p->tag;
+    void *base = high_alloc(4 << 20), *entry = guest_alloc(PAGE_SIZE);
+
+    fill(base, 4 << 20, 6);
+
+    *tag = (struct skl_tag_boot_simple_payload64){
+        .hdr = { SKL_TAG_BOOT_SIMPLE64, sizeof(*tag) },
+        .base = _u(base),
+        .size = 4 << 20,
+        .entry = _u(entry),
+        .arg = 0x5678,
+    };
+
+    p->evtlog64 = true;
+    p->protocol = SIMPLE_PAYLOAD;
+    p->ret = (asm_return_t){ entry, _p(0x5678) };
+
+    add_measurement(p, 17, base, 4 << 20);
+    p->m[p->nr_m - 1].tree = true;
+}
+
+/* Regions passed with SKL_TAG_SETUP_INDIRECT, measured after the payload */
+static struct indirect {
+    unsigned int pcr;
+    const char *label;
+    u32 size;
+    bool high;
+    void *data;
+} indirect[] = {
+    { 18, "Measured DTB into PCR18", 64 << 10 },
+    { 17, "Measured firmware into PCR17", 2 << 20, true },
+};
+
+static void make_indirect(void)
+{
+    for ( unsigned int i = 0; i < ARRAY_SIZE(indirect); i++ )
+    {
+        indirect[i].data = indirect[i].high ? high_alloc(indirect[i].size)
+                                            : guest_alloc(indirect[i].size);
+        fill(indirect[i].data, indirect[i].size, 5 + i);
+    }
+}
+
+static u8 skl_sha1[SHA1_DIGEST_SIZE], skl_sha256[SHA256_DIGEST_SIZE];
+static u8 *evtlog;
+static struct skl_digest_table *digests;
+
+/* What a bootloader would put after the SLB */
+static void write_bootloader_data(const struct payload *p, u32 policy)
+{
+    u8 *start = sim_slb + SIM_BOOTLOADER_DATA, *pos = start;
+    struct skl_tag_setup_indirect *si;
+    struct skl_tag_measure_policy *mp;
+    struct skl_tag_digest_table *dt;
+    struct skl_tag_evtlog64 *el64;
+    struct skl_tag_evtlog *el;
+    struct skl_tag_hash *h;
+
+    memset(pos, 0, SLB_SIZE - SIM_BOOTLOADER_DATA);
+    pos += sizeof(struct skl_tag_tags_size);
+
+    memcpy(pos, p->tag, ((struct skl_tag_hdr *)p->tag)->len);
+    pos += ((struct skl_tag_hdr *)p->tag)->len;
+
+    if ( p->evtlog64 )
+    {
+        el64 = (void *)pos;
+        *el64 = (struct skl_tag_evtlog64){
+            .hdr = { SKL_TAG_EVENT_LOG64, sizeof(*el64) },
+            .address = _u(evtlog),
+            .size = EVTLOG_SIZE,
+        };
+        pos += sizeof(*el64);
+    }
+    else
+    {
+        el = (void *)pos;
+        *el = (struct skl_tag_evtlog){
+            .hdr = { SKL_TAG_EVENT_LOG, sizeof(*el) },
+            .address = _u(evtlog),
+            .size = EVTLOG_SIZE,
+        };
+        pos += sizeof(*el);
+    }
+
+    h = (void *)pos;
+    h->hdr = (struct skl_tag_hdr){ SKL_TAG_SKL_HASH,
+                                   sizeof(*h) + SHA1_DIGEST_SIZE };
+    h->algo_id = TPM_ALG_SHA1;
+    memcpy(h->digest, skl_sha1, SHA1_DIGEST_SIZE);
+    pos += h->hdr.len;
+
+    h = (void *)pos;
+    h->hdr = (struct skl_tag_hdr){ SKL_TAG_SKL_HASH,
+                                   sizeof(*h) + SHA256_DIGEST_SIZE };
+    h->algo_id = TPM_ALG_SHA256;
+    memcpy(h->digest, skl_sha256, SHA256_DIGEST_SIZE);
+    pos += h->hdr.len;
+
+    for ( unsigned int i = 0; i < ARRAY_SIZE(indirect); i++ )
+    {
+        si = (void *)pos;
+        *si = (struct skl_tag_setup_indirect){
+            .hdr = { SKL_TAG_SETUP_INDIRECT,
+                     sizeof(*si) + strlen(indirect[i].label) + 1 },
+            .data = {
+                .type = SETUP_INDIRECT,
+                .len = sizeof(struct setup_indirect),
+                .indirect = {
+                    .type = 2,                  /* SETUP_DTB */
+                    .len = indirect[i].size,
+                    .addr = _u(indirect[i].data),
+                },
+            },
+            .pcr = indirect[i].pcr,
+        };
+        strcpy(si->label, indirect[i].label);
+        pos += si->hdr.len;
+    }
+
+    dt = (void *)pos;
+    *dt = (struct skl_tag_digest_table){
+        .hdr = { SKL_TAG_DIGEST_TABLE, sizeof(*dt) },
+        .address = _u(digests),
+        .size = DIGEST_TABLE_SIZE,
+    };
+    pos += sizeof(*dt);
+
+    if ( policy )
+    {
+        mp = (void *)pos;
+        *mp = (struct skl_tag_measure_policy){
+            .hdr = { SKL_TAG_MEASURE_POLICY, sizeof(*mp) },
+            .flags = policy,
+        };
+        pos += sizeof(*mp);
+    }
+
+    *(struct skl_tag_hdr *)pos = (struct skl_tag_hdr){ SKL_TAG_END,
+                                                       sizeof(struct skl_tag_hdr) };
+    pos += sizeof(struct skl_tag_hdr);
+
+    *(struct skl_tag_tags_size *)start = (struct skl_tag_tags_size){
+        .hdr = { SKL_TAG_TAGS_SIZE, sizeof(struct skl_tag_tags_size) },
+        .size = pos - start,
+    };
+}
+
+#define CHECK(cond, ...)                        \
+    do {                                        \
+        if ( !(cond) )                          \
+        {                                       \
+            printf("  ");                       \
+            printf(__VA_ARGS__);                \
+            printf("\n");                       \
+            fail = true;                        \
+        }                                       \
+    } while ( 0 )
+
+static void hash_bank(bool sha256, u8 *out, const void *data, u64 size)
+{
+    if ( sha256 )
+        sha256sum(out, data, size);
+    else
+        sha1sum(out, data, size);
+}
+
+/* The tree over chunks [lo, hi) of m, spelled out as merkle.h has it */
+static void merkle_subtree(bool sha256, const struct measurement *m,
+                           u64 lo, u64 hi, u8 *out)
+{
+    u32 size = sha256 ? SHA256_DIGEST_SIZE : SHA1_DIGEST_SIZE;
+    u8 buf[1 + 2 * SHA256_DIGEST_SIZE];
+    u64 k = 1, off = lo * MERKLE_CHUNK_SIZE;
+
+    if ( hi - lo == 1 )
+    {
+        hash_bank(sha256, out, m->data + off,
+                  m->size - off < MERKLE_CHUNK_SIZE ? m->size - off
+                                                    : MERKLE_CHUNK_SIZE);
+        return;
+    }
+
+    while ( k * 2 < hi - lo )
+        k *= 2;
+
+    buf[0] = MERKLE_NODE;
+    merkle_subtree(sha256, m, lo, lo + k, buf + 1);
+    merkle_subtree(sha256, m, lo + k, hi, buf + 1 + size);
+    hash_bank(sha256, out, buf, 1 + 2 * size);
+}
+
+static const struct skl_merkle_event *merkle_event(const struct measurement *m)
+{
+    static struct skl_merkle_event ev;
+
+    ev = (struct skl_merkle_event){
+        .magic = SKL_MERKLE_MAGIC,
+        .version = SKL_MERKLE_VERSION,
+        .chunk_shift = MERKLE_CHUNK_SHIFT,
+        .size = m->size,
+    };
+
+    return &ev;
+}
+
+/* What m's event should have in the given bank */
+static void expected_digest(bool sha256, const struct measurement *m, u8 *out)
+{
+    u32 size = sha256 ? SHA256_DIGEST_SIZE : SHA1_DIGEST_SIZE;
+    u8 buf[1 + sizeof(struct skl_merkle_event) + SHA256_DIGEST_SIZE];
+
+    if ( !m->tree )
+    {
+        hash_bank(sha256, out, m->data, m->size);
+        return;
+    }
+
+    buf[0] = MERKLE_ROOT;
+    memcpy(buf + 1, merkle_event(m), sizeof(struct skl_merkle_event));
+    merkle_subtree(sha256, m, 0, merkle_chunks(m->size),
+                   buf + 1 + sizeof(struct skl_merkle_event));
+    hash_bank(sha256, out, buf, 1 + sizeof(struct skl_merkle_event) + size);
+}
+
+/*
+ * Is an event exactly the measurement expected of it?  A tree's event data
+ * has to start with the header its digest covers.
+ */
+static bool check_event(unsigned int i, const struct measurement *m,
+                        u32 pcr, const u8 *sha1, const u8 *sha256,
+                        const void *data, u32 size)
+{
+    u8 hash[SHA256_DIGEST_SIZE];
+    bool fail = false;
+
+    CHECK(pcr == m->pcr, "Event %u: PCR%u, expected PCR%u", i, pcr, m->pcr);
+
+    if ( m->tree )
+        CHECK(size >= sizeof(struct skl_merkle_event) &&
+              !memcmp(data, merkle_event(m), sizeof(struct skl_merkle_event)),
+              "Event %u: bad Merkle tree header", i);
+
+    expected_digest(false, m, hash);
+    CHECK(!memcmp(hash, sha1, SHA1_DIGEST_SIZE), "Event %u: bad SHA1", i);
+
+    if ( sha256 )
+    {
+        expected_digest(true, m, hash);
+        CHECK(!memcmp(hash, sha256, SHA256_DIGEST_SIZE),
+              "Event %u: bad SHA256", i);
+    }
+
+    return fail;
+}
+
+/* PCR := H(PCR || digest), the same as the TPM model does it */
+static void replay_extend(u8 *pcr_sha1, const u8 *sha1,
+                          u8 *pcr_sha256, const u8 *sha256)
+{
+    u8 buf[2 * SHA256_DIGEST_SIZE];
+
+    memcpy(buf, pcr_sha1, SHA1_DIGEST_SIZE);
+    memcpy(buf + SHA1_DIGEST_SIZE, sha1, SHA1_DIGEST_SIZE);
+    sha1sum(pcr_sha1, buf, 2 * SHA1_DIGEST_SIZE);
+
+    if ( !sha256 )
+        return;
+
+    memcpy(buf, pcr_sha256, SHA256_DIGEST_SIZE);
+    memcpy(buf + SHA256_DIGEST_SIZE, sha256, SHA256_DIGEST_SIZE);
+    sha256sum(pcr_sha256, buf, 2 * SHA256_DIGEST_SIZE);
+}
+
+/* From the EV_NO_ACTION event skl_main() logs once the TPM is ready */
+static u64 tpm_overlap, tpm_waited, tpm_locality, tpm_idle;
+
+static bool is_bringup_event(u32 type, const char *data, u32 size)
+{
+    static const char prefix[] = "TPM bring-up TSC ticks: ";
+
+    return type == EV_NO_ACTION && size >= sizeof(prefix) - 1 &&
+           !memcmp(data, prefix, sizeof(prefix) - 1);
+}
+
+/*
+ * CRB also logs how long the locality requests and goIdle took, which have
+ * to be waited out rather than taking a fixed 200ms.  Both localities, 0 and
+ * then 2, are granted and the TPM starts out ready.
+ */
+static bool check_bringup_event(const struct tpm_flavour *f, unsigned int i,
+                                const u8 *sha1, const u8 *sha256,
+                                const char *data, u32 size)
+{
+    static const u8 zero[SHA256_DIGEST_SIZE];
+    char str[160] = {};
+    bool fail = false;
+    int n;
+
+    CHECK(tpm_overlap == ~0ULL, "Event %u: second TPM bring-up event", i);
+    CHECK(!memcmp(sha1, zero, SHA1_DIGEST_SIZE) &&
+          (!sha256 || !memcmp(sha256, zero, SHA256_DIGEST_SIZE)),
+          "Event %u: non-zero digest", i);
+
+    memcpy(str, data, size < sizeof(str) ? size : sizeof(str) - 1);
+    n = sscanf(str, "TPM bring-up TSC ticks: overlapped %"SCNx64
+               ", waited %"SCNx64", locality %"SCNx64", idle %"SCNx64,
+               &tpm_overlap, &tpm_waited, &tpm_locality, &tpm_idle);
+    CHECK(n == (f->intf == TPM_CRB ? 4 : 2),
+          "Event %u: bad TPM bring-up event '%s'", i, str);
+
+    /* Timed from after the request's MMIO write, which the model charges */
+    if ( f->intf == TPM_CRB && n == 4 )
+    {
+        CHECK(tpm_locality >= 2 * (TICKS_TPM_GRANT - TICKS_TPM_MMIO) &&
+              tpm_locality < 4 * TICKS_TPM_GRANT,
+              "Event %u: localities took %"PRIu64" ticks", i, tpm_locality);
+        CHECK(tpm_idle >= TICKS_TPM_IDLE - TICKS_TPM_MMIO &&
+              tpm_idle < 2 * TICKS_TPM_IDLE,
+              "Event %u: goIdle took %"PRIu64" ticks", i, tpm_idle);
+    }
+
+    return fail;
+}
+
+/*
+ * Walk the log as the kernel would, replaying it into a set of PCRs which
+ * must end up matching the TPM's, bar the event recording TPM bring-up.  When
+ * aggregating, the measurements are EV_TYPE_SLAUNCH_AGGREGATED events which
+ * only go into the composites, and the composites follow them, PCR17 first.
+ * Trees are otherwise EV_TYPE_SLAUNCH_MERKLE events.
+ */
+static bool check_event_log(const struct tpm_flavour *f,
+                            const struct measurement *m, unsigned int nr_m,
+                            u32 policy)
+{
+    bool aggregate = policy & SKL_MEASURE_AGGREGATE;
+    u8 pcr_sha1[TPM_MODEL_PCRS][SHA1_DIGEST_SIZE] = {};
+    u8 pcr_sha256[TPM_MODEL_PCRS][SHA256_DIGEST_SIZE] = {};
+    u8 comp_sha1[2][SHA1_DIGEST_SIZE] = {};
+    u8 comp_sha256[2][SHA256_DIGEST_SIZE] = {};
+    const tpm12_event_t *hdr = (void *)evtlog;
+    const u8 *pos = evtlog + sizeof(*hdr) + hdr->event_size, *end;
+    unsigned int i, k = 0, pcr, nr_comp = 0, type;
+    bool fail = false;
+
+    tpm_overlap = tpm_waited = tpm_locality = tpm_idle = ~0ULL;
+
+    if ( f->family == TPM12 )
+    {
+        const tpm12_spec_id_ev_t *id = (void *)(hdr + 1);
+
+        end = (u8 *)&id->hdr + id->hdr.next_event_offset;
+    }
+    else
+    {
+        const tpm20_spec_id_ev_t *id = (void *)(hdr + 1);
+
+        end = evtlog + id->el.next_record_offset;
+    }
+
+    CHECK(end == ptr_current, "Log header ends the log at %+td bytes",
+          end - ptr_current);
+
+    /* Only the records and the sentinel after them are written */
+    for ( i = 0; i < EVTLOG_SENTINEL; i++ )
+        CHECK(!ptr_current[i], "Sentinel byte %u is %#x", i, ptr_current[i]);
+    CHECK(ptr_current[EVTLOG_SENTINEL] == EVTLOG_JUNK,
+          "Log cleared past the sentinel");
+
+    /* Event 0 is SKINIT, the measurements are expected to match m[] */
+    for ( i = 0; pos < end; i++ )
+    {
+        const u8 *sha1, *sha256 = NULL;
+        const char *data;
+        u32 size;
+
+        if ( f->family == TPM12 )
+        {
+            const tpm12_event_t *ev = (void *)pos;
+
+            pcr = ev->pcr;
+            type = ev->event_type;
+            sha1 = ev->digest;
+            data = (void *)(ev + 1);
+            size = ev->event_size;
+        }
+        else
+        {
+            const tpm20_event_t *ev = (void *)pos;
+
+            CHECK(ev->digests.count == 2 &&
+                  ev->digests.sha1_id == TPM_ALG_SHA1 &&
+                  ev->digests.sha256_id == TPM_ALG_SHA256,
+                  "Event %u: bad digest list", i);
+            pcr = ev->pcr;
+            type = ev->event_type;
+            sha1 = ev->digests.sha1_hash;
+            sha256 = ev->digests.sha256_hash;
+            data = (void *)(ev + 1);
+            size = ev->event_size;
+        }
+
+        pos = (const u8 *)data + size;
+
+        if ( i > 0 && is_bringup_event(type, data, size) )
+        {
+            fail |= check_bringup_event(f, i, sha1, sha256, data, size);
+            continue;
+        }
+
+        if ( pcr >= TPM_MODEL_PCRS )
+        {
+            CHECK(false, "Event %u: bad PCR %u", i, pcr);
+            return fail;
+        }
+
+        CHECK(type == (k < nr_m && m[k].tree ? EV_TYPE_SLAUNCH_MERKLE
+                                             : EV_TYPE_SLAUNCH) ||
+              (aggregate && type == EV_TYPE_SLAUNCH_AGGREGATED),
+              "Event %u: bad type %#x", i, type);
+
+        if ( i == 0 )
+            CHECK(pcr == 17 && !memcmp(sha1, skl_sha1, SHA1_DIGEST_SIZE),
+                  "Event 0 isn't SKINIT");
+        else if ( aggregate && type == EV_TYPE_SLAUNCH )
+        {
+            CHECK(k == nr_m, "Event %u: composite before measurements", i);
+            CHECK(pcr == 17 + nr_comp, "Event %u: composite for PCR%u", i, pcr);
+            CHECK(pcr < 17 || pcr > 18 ||
+                  (!memcmp(sha1, comp_sha1[pcr - 17], SHA1_DIGEST_SIZE) &&
+                   (!sha256 || !memcmp(sha256, comp_sha256[pcr - 17],
+                                       SHA256_DIGEST_SIZE))),
+                  "Event %u: bad composite", i);
+            nr_comp++;
+        }
+        else if ( k < nr_m )
+            fail |= check_event(i, &m[k++], pcr, sha1, sha256, data, size);
+
+        if ( type == EV_TYPE_SLAUNCH_AGGREGATED )
+        {
+            if ( pcr >= 17 && pcr <= 18 )
+                replay_extend(comp_sha1[pcr - 17], sha1,
+                              comp_sha256[pcr - 17], sha256);
+            continue;
+        }
+
+        replay_extend(pcr_sha1[pcr], sha1, pcr_sha256[pcr], sha256);
+    }
+
+    CHECK(tpm_overlap != ~0ULL, "No TPM bring-up event");
+    CHECK(k == nr_m, "%u measurements, expected %u", k, nr_m);
+    CHECK(nr_comp == (aggregate ? 2 : 0), "%u composites, expected %u",
+          nr_comp, aggregate ? 2 : 0);
+
+    for ( pcr = 17; pcr <= 18; pcr++ )
+    {
+        CHECK(!memcmp(pcr_sha1[pcr], tpm_model.pcr_sha1[pcr],
+                      SHA1_DIGEST_SIZE),
+              "PCR%u SHA1 bank doesn't match the log", pcr);
+        CHECK(f->family == TPM12 ||
+              !memcmp(pcr_sha256[pcr], tpm_model.pcr_sha256[pcr],
+                      SHA256_DIGEST_SIZE),
+              "PCR%u SHA256 bank doesn't match the log", pcr);
+    }
+
+    return fail;
+}
+
+/*
+ * Below 4G, the second and third GB are 1G pages, as plat_reset()'s MTRRs
+ * only split the fourth, and the first always keeps its L2.  Above, exactly
+ * the 1G pages covering what was measured there are mapped.
+ */
+static bool check_l3(const struct measurement *m, unsigned int nr_m)
+{
+    u64 expect[ARRAY_SIZE(l3_identmap)] = {
+        L3_TO_L2(0), L3_1G(1), L3_1G(2), L3_TO_L2(3),
+    }, pg, start, end;
+    unsigned int i;
+    bool fail = false;
+
+    for ( i = 0; i < nr_m; i++ )
+    {
+        start = _u(m[i].data);
+        end = start + m[i].size;
+        if ( start < HIGH_BASE || end > HIGH_BASE + HIGH_SIZE )
+            continue;
+
+        for ( pg = start >> L3_PT_SHIFT; pg << L3_PT_SHIFT < end; pg++ )
+            expect[pg] = L3_1G(pg);
+    }
+
+    for ( i = 0; i < ARRAY_SIZE(l3_identmap); i++ )
+        CHECK(l3_identmap[i] == expect[i],
+              "L3[%u] is %#"PRIx64", expected %#"PRIx64,
+              i, l3_identmap[i], expect[i]);
+    CHECK(plat.tlb_flushes == 1, "TLB flushed %lu times, expected once",
+          plat.tlb_flushes);
+
+    return fail;
+}
+
+/*
+ * The digest table has an entry per bank for each of m[] in one piece and
+ * not as a tree, in order, and each digest has to be of the memory the entry
+ * says it is.
+ */
+static bool check_digest_table(const struct tpm_flavour *f,
+                               const struct measurement *m, unsigned int nr_m)
+{
+    static const u16 algos[] = { TPM_ALG_SHA1, TPM_ALG_SHA256 };
+    unsigned int i, b, banks = f->family == TPM20 ? 2 : 1, e = 0, nr_e = 0;
+    u8 digest[SHA256_DIGEST_SIZE];
+    bool fail = false;
+
+    CHECK(digests->magic == SKL_DIGEST_TABLE_MAGIC &&
+          digests->version == SKL_DIGEST_TABLE_VERSION && !digests->flags,
+          "Digest table header %#x/%u/%#x", digests->magic, digests->version,
+          digests->flags);
+
+    for ( i = 0; i < nr_m; i++ )
+        nr_e += m[i].in_pieces || m[i].tree ? 0 : banks;
+    CHECK(digests->count == nr_e, "%u digests in the table, expected %u",
+          digests->count, nr_e);
+    if ( fail )
+        return fail;
+
+    for ( i = 0; i < nr_m; i++ )
+    {
+        if ( m[i].in_pieces || m[i].tree )
+            continue;
+
+        for ( b = 0; b < banks; b++, e++ )
+        {
+            const struct skl_digest_entry *d = &digests->entries[e];
+
+            CHECK(d->address == _u(m[i].data) && d->length == m[i].size &&
+                  d->pcr == m[i].pcr && d->algo_id == algos[b],
+                  "Digest %u is %#"PRIx64"+%#"PRIx64" PCR%u alg %#x, "
+                  "expected %p+%#x PCR%u alg %#x", e, d->address, d->length,
+                  d->pcr, d->algo_id, m[i].data, m[i].size, m[i].pcr,
+                  algos[b]);
+
+            if ( b == 0 )
+                sha1sum(digest, _p(d->address), d->length);
+            else
+                sha256sum(digest, _p(d->address), d->length);
+            CHECK(!memcmp(d->digest, digest, b == 0 ? SHA1_DIGEST_SIZE
+                                                    : SHA256_DIGEST_SIZE),
+                  "Digest %u isn't of its region", e);
+        }
+    }
+
+    return fail;
+}
+
+static const char *policy_name(u32 policy)
+{
+    switch ( policy & (SKL_MEASURE_AGGREGATE | SKL_MEASURE_MERKLE) )
+    {
+    case SKL_MEASURE_AGGREGATE:
+        return ", aggregated";
+    case SKL_MEASURE_MERKLE:
+        return ", Merkle";
+    case SKL_MEASURE_AGGREGATE | SKL_MEASURE_MERKLE:
+        return ", aggregated, Merkle";
+    default:
+        return "";
+    }
+}
+
+/*
+ * Without 1G pages there is no reaching memory above 4G, which every launch
+ * has in it, and with the IOMMU hung nothing is protected from DMA, so in
+ * either case skl_main() must give up rather than hand over.
+ */
+static bool launch(const struct payload *p, const struct tpm_flavour *f,
+                   u32 policy, bool page1gb, bool hang)
+{
+    struct measurement m[MAX_MEASUREMENTS + 2 + ARRAY_SIZE(indirect)];
+    unsigned int i, nr_m = 0;
+    volatile bool fail = false;
+    asm_return_t ret;
+    jmp_buf died;
+    u64 ticks;
+    /* A build for one kind of TPM has to refuse any other */
+    bool built_for = TPM_INTF(f->intf) == f->intf &&
+                     TPM_FAMILY(f->family) == f->family;
+
+    plat_reset(true, false, false, 1);
+    plat.page1gb = page1gb;
+    plat.iommu[0].hang = hang;
+    memset(l3_identmap, 0, sizeof(l3_identmap));
+    for ( i = 0; i < 4; i++ )
+        l3_identmap[i] = L3_TO_L2(i);
+    model_tpm_reset(f->family, f->intf, skl_sha1, skl_sha256);
+    write_bootloader_data(p, policy);
+    memset(evtlog, EVTLOG_JUNK, EVTLOG_SIZE);
+    memset(digests, EVTLOG_JUNK, DIGEST_TABLE_SIZE);
+    /* Written through sim_slb, which the compiler can't tell is aliased */
+    barrier();
+    bytes_hashed = bytes_unflushed = 0;
+
+    /* A real launch starts with these as the loader left them */
+    boot_protocol = LINUX_BOOT;
+    memset(&tpm, 0, sizeof(tpm));
+    memset(&tpm_buff, 0, sizeof(tpm_buff));
+    measure_flags = 0;
+    memset(composite, 0, sizeof(composite));
+    nr_pending = 0;
+    tpm_started = 0;
+    memset(&crb_waits, 0, sizeof(crb_waits));
+    table = NULL;
+
+    m[nr_m++] = (struct measurement){ 18, &bootloader_data,
+                                      bootloader_data.size };
+    for ( i = 0; i < p->nr_m; i++ )
+    {
+        m[nr_m] = p->m[i];
+        m[nr_m++].tree &= !!(policy & SKL_MEASURE_MERKLE);
+    }
+    for ( i = 0; i < ARRAY_SIZE(indirect); i++ )
+        m[nr_m++] = (struct measurement){ indirect[i].pcr, indirect[i].data,
+                                          indirect[i].size };
+
+    plat.die_jmp = &died;
+    if ( setjmp(died) )
+    {
+        if ( !built_for )
+        {
+            printf("Ok: %s, %s%s, not built for it: rebooted at TSC %"PRIu64
+                   "\n", p->name, f->name, policy_name(policy),
+                   plat.tsc);
+            return false;
+        }
+
+        if ( hang )
+        {
+            printf("%s: %s, %s, IOMMU hung: rebooted at TSC %"PRIu64
+                   ", %"PRIu64" bytes hashed\n",
+                   bytes_hashed ? "Fail" : "Ok", p->name, f->name, plat.tsc,
+                   bytes_hashed);
+            return bytes_hashed;
+        }
+
+        if ( !page1gb )
+        {
+            printf("Ok: %s, %s, no 1G pages: rebooted at TSC %"PRIu64"\n",
+                   p->name, f->name, plat.tsc);
+            return false;
+        }
+
+        printf("Fail: %s, %s%s: died at TSC %"PRIu64"\n",
+               p->name, f->name, policy_name(policy), plat.tsc);
+        return true;
+    }
+
+    ret = skl_main();
+    ticks = plat.tsc;
+    plat.die_jmp = NULL;
+
+    /* Let the last command finish, the kernel may find the TPM still busy. */
+    while ( tpm_model.state == TPM_STATE_EXECUTION )
+        plat_tick(TICKS_RELAX);
+
+    CHECK(page1gb, "Launched without 1G pages");
+    CHECK(!hang, "Launched with the IOMMU flush hung");
+    CHECK(bytes_unflushed == 0, "%"PRIu64" bytes hashed before IOMMU flush",
+          bytes_unflushed);
+    CHECK(built_for, "Launched with a TPM it wasn't built for");
+    CHECK(ret.pm_kernel_entry == p->ret.pm_kernel_entry &&
+          ret.zero_page == p->ret.zero_page,
+          "Returned %p/%p, expected %p/%p",
+          ret.pm_kernel_entry, ret.zero_page,
+          p->ret.pm_kernel_entry, p->ret.zero_page);
+    CHECK(boot_protocol == p->protocol, "boot_protocol %u, expected %u",
+          boot_protocol, p->protocol);
+    CHECK(tpm_model.bad_commands == 0, "%u TPM commands failed",
+          tpm_model.bad_commands);
+    /* tpm_poll() backs off to TPM_POLL_MAX_DELAY between reads, no further */
+    CHECK(tpm_model.rsp_lag < 2 * TPM_POLL_MAX_DELAY * 1000,
+          "A TPM response sat unread for %"PRIu64" ticks", tpm_model.rsp_lag);
+    CHECK(!plat_slb_protected(), "SLB protection still enabled");
+    fail |= check_digest_table(f, m, nr_m);
+    /* Measured last of all, which the table can't say of itself */
+    m[nr_m++] = (struct measurement){ 18, digests, sizeof(*digests) +
+                                      digests->count * sizeof(digests->entries[0]) };
+    fail |= check_event_log(f, m, nr_m, policy);
+    fail |= check_l3(m, nr_m);
+
+    printf("%s: %s, %s%s: %"PRIu64".%03"PRIu64" ms, %"PRIu64" bytes hashed, "
+           "%u TPM commands, %td event log bytes\n",
+           fail ? "Fail" : "Ok", p->name, f->name,
+           policy_name(policy),
+           ticks / 1000000, ticks / 1000 % 1000, bytes_hashed,
+           tpm_model.commands, ptr_current - evtlog);
+    if ( !fail )
+        printf("  TPM bring-up: %"PRIu64".%03"PRIu64" ms overlapped with "
+               "hashing, %"PRIu64".%03"PRIu64" ms waited\n",
+               tpm_overlap / 1000000, tpm_overlap / 1000 % 1000,
+               tpm_waited / 1000000, tpm_waited / 1000 % 1000);
+    if ( !fail && f->intf == TPM_CRB )
+        printf("  CRB transitions: %"PRIu64" us for localities, "
+               "%"PRIu64" us for goIdle\n",
+               tpm_locality / 1000, tpm_idle / 1000);
+    if ( !fail && tpm_model.rsp_lag )
+        printf("  TIS responses: up to %"PRIu64" us unread\n",
+               tpm_model.rsp_lag / 1000);
+
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    struct payload payloads[4] = {
+        { .name = "Linux" }, { .name = "Multiboot2" }, { .name = "Simple" },
+        { .name = "Simple64" },
+    };
+    struct payload mb2_elf64 = { .name = "Multiboot2, ELF64" };
+    static const u32 policies[] = {
+        0, SKL_MEASURE_AGGREGATE, SKL_MEASURE_MERKLE,
+        SKL_MEASURE_AGGREGATE | SKL_MEASURE_MERKLE,
+    };
+    bool fail = false, real[3] = {};
+    unsigned int i, j, k;
+
+    evtlog = guest_alloc(EVTLOG_SIZE);
+    digests = guest_alloc(DIGEST_TABLE_SIZE);
+
+    for ( i = 1; i < argc; i++ )
+    {
+        u32 size, initrd_size = 0;
+        void *image, *initrd = NULL;
+
+        if ( !strcmp(argv[i], "--linux") && i + 1 < argc )
+        {
+            image = load_file(argv[++i], &size);
+            if ( i + 1 < argc && argv[i + 1][0] != '-' )
+                initrd = load_file(argv[++i], &initrd_size);
+            linux_payload(&payloads[0], image, size, initrd, initrd_size);
+            real[0] = true;
+        }
+        else if ( !strcmp(argv[i], "--mb2") && i + 1 < argc )
+        {
+            void *kernel, *mods[MAX_MEASUREMENTS - 2];
+            u32 sizes[MAX_MEASUREMENTS - 2];
+            const char *names[MAX_MEASUREMENTS - 2];
+            unsigned int nr = 0;
+            /* A loaded image, as one section */
+            Elf32_Shdr sh[2] = {
+                { .sh_type = SHT_NULL },
+                { .sh_type = SHT_PROGBITS, .sh_flags = SHF_ALLOC },
+            };
+
+            kernel = load_file(argv[++i], &sh[1].sh_size);
+            while ( i + 1 < argc && argv[i + 1][0] != '-' &&
+                    nr < ARRAY_SIZE(mods) )
+            {
+                names[nr] = argv[++i];
+                mods[nr] = load_file(names[nr], &sizes[nr]);
+                nr++;
+            }
+            mb2_payload(&payloads[1], kernel, sh, ARRAY_SIZE(sh), false, nr,
+                        mods, sizes, names);
+            real[1] = true;
+        }
+        else if ( !strcmp(argv[i], "--simple") && i + 1 < argc )
+        {
+            image = load_file(argv[++i], &size);
+            simple_payload(&payloads[2], image, size);
+            real[2] = true;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--linux bzImage [initrd]] [--mb2 "
+                    "kernel module...] [--simple file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ( !real[0] )
+        make_linux(&payloads[0], 8 << 20, 16 << 20);
+    if ( !real[1] )
+        make_mb2(&payloads[1], false);
+    make_mb2(&mb2_elf64, true);
+    if ( !real[2] )
+        make_simple(&payloads[2]);
+    make_simple64(&payloads[3]);
+    make_indirect();
+
+    /* What a bootloader would pass in SKL_TAG_SKL_HASH */
+    sha1sum(skl_sha1, sim_slb, SIM_BOOTLOADER_DATA);
+    sha256sum(skl_sha256, sim_slb, SIM_BOOTLOADER_DATA);
+
+    for ( i = 0; i < ARRAY_SIZE(payloads); i++ )
+        for ( j = 0; j < ARRAY_SIZE(tpms); j++ )
+            for ( k = 0; k < ARRAY_SIZE(policies); k++ )
+                fail |= launch(&payloads[i], &tpms[j], policies[k], true,
+                               false);
+
+    for ( i = 0; i < ARRAY_SIZE(payloads); i++ )
+        fail |= launch(&payloads[i], &tpms[ARRAY_SIZE(tpms) - 1], 0, false,
+                       false);
+
+    fail |= launch(&payloads[0], &tpms[ARRAY_SIZE(tpms) - 1], 0, true, true);
+    fail |= launch(&mb2_elf64, &tpms[ARRAY_SIZE(tpms) - 1], 0, true, false);
+
+#ifdef LAUNCH_EXTRA_TESTS
+    fail |= LAUNCH_EXTRA_TESTS();
+#endif
+
+    if ( !fail )
+        printf("All ok\n");
+
+    return fail;
+}
@@ -0,0 +1,169 @@
+/*
+ * Hash throughput over memory mapped with 4K, 2M and 1G pages, as head.S,
+ * map_gigabytes() and map_phys() may leave payloads mapped.  On the host, 2M pages come from
+ * transparent huge pages and 1G pages from hugetlbfs, which is skipped if
+ * none are reserved.  The digests have to be the same whatever the mapping.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "sha1sum.c"
+#include "sha256.c"
+
+#define SIZE            (32 << 20)
+#define RUNS            3           /* Best of, the host is noisy */
+#define SIZE_2M         (2 << 20)
+#define SIZE_1G         (1 << 30)
+
+static void *map_4k(void)
+{
+    void *p = mmap(NULL, SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if ( p == MAP_FAILED )
+        return NULL;
+
+    madvise(p, SIZE, MADV_NOHUGEPAGE);
+    return p;
+}
+
+static void *map_2m(void)
+{
+    u8 *p = mmap(NULL, SIZE + SIZE_2M, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if ( p == MAP_FAILED )
+        return NULL;
+
+    p = _p((_u(p) + SIZE_2M - 1) & ~(SIZE_2M - 1UL));
+    madvise(p, SIZE, MADV_HUGEPAGE);
+    return p;
+}
+
+static void *map_1g(void)
+{
+    void *p = mmap(NULL, SIZE_1G, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                   (30 << MAP_HUGE_SHIFT), -1, 0);
+
+    return p == MAP_FAILED ? NULL : p;
+}
+
+static const struct mapping {
+    const char *name;
+    void *(*map)(void);
+    bool optional;              /* Needs pages reserved up front */
+} mappings[] = {
+    { "4K pages", map_4k },
+    { "2M pages", map_2m },
+    { "1G pages", map_1g, true },
+};
+
+/* Deterministic junk, standing in for a payload */
+static void fill(void *p, size_t size, u32 seed)
+{
+    u8 *b = p;
+
+    while ( size-- )
+    {
+        seed = seed * 1103515245 + 12345;
+        *b++ = seed >> 16;
+    }
+}
+
+/* How much of [p, p + SIZE) the kernel backed with huge pages, in KiB */
+static unsigned long huge_kb(const void *p)
+{
+    FILE *f = fopen("/proc/self/smaps", "r");
+    unsigned long start, end, kb = 0;
+    bool in = false;
+    char line[256];
+
+    if ( !f )
+        return 0;
+
+    while ( fgets(line, sizeof(line), f) )
+    {
+        if ( sscanf(line, "%lx-%lx ", &start, &end) == 2 )
+            in = start <= _u(p) && _u(p) < end;
+        else if ( in && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 )
+            break;
+    }
+
+    fclose(f);
+    return kb;
+}
+
+static u64 now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * (u64)1000000000 + ts.tv_nsec;
+}
+
+int main(void)
+{
+    u8 sha1[ARRAY_SIZE(mappings)][SHA1_DIGEST_SIZE];
+    u8 sha256[ARRAY_SIZE(mappings)][SHA256_DIGEST_SIZE];
+    bool fail = false;
+    u64 t0, t1, t2, best1 = 0, best256 = 0;
+
+    for ( unsigned int i = 0; i < ARRAY_SIZE(mappings); ++i )
+    {
+        const struct mapping *m = &mappings[i];
+        void *p = m->map();
+
+        if ( !p )
+        {
+            printf("%s: %s, can't map\n",
+                   m->optional ? "Skipped" : "Fail", m->name);
+            fail |= !m->optional;
+            continue;
+        }
+
+        /* Fault everything in before the clock starts */
+        fill(p, SIZE, 1);
+
+        for ( unsigned int r = 0; r < RUNS; ++r )
+        {
+            t0 = now_ns();
+            sha1sum(sha1[i], p, SIZE);
+            t1 = now_ns();
+            sha256sum(sha256[i], p, SIZE);
+            t2 = now_ns();
+
+            if ( r == 0 || t1 - t0 < best1 )
+                best1 = t1 - t0;
+            if ( r == 0 || t2 - t1 < best256 )
+                best256 = t2 - t1;
+        }
+
+        if ( i > 0 && (memcmp(sha1[i], sha1[0], SHA1_DIGEST_SIZE) ||
+                       memcmp(sha256[i], sha256[0], SHA256_DIGEST_SIZE)) )
+        {
+            printf("Fail: %s, digests differ from %s\n",
+                   m->name, mappings[0].name);
+            fail = true;
+            continue;
+        }
+
+        printf("Ok: %s: SHA1 %"PRIu64" MB/s, SHA256 %"PRIu64" MB/s",
+               m->name, (u64)SIZE * 1000 / best1,
+               (u64)SIZE * 1000 / best256);
+        if ( m->map == map_2m )
+            printf(", %lu of %u KiB in huge pages", huge_kb(p), SIZE >> 10);
+        printf("\n");
+    }
+
+    if ( !fail )
+        printf("All ok\n");
+
+    return fail;
+}
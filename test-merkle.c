@@ -0,0 +1,213 @@
+/*
+ * merkle_add() and merkle_finish() giving the digests of a recursive RFC 6962
+ * style tree, for objects of a whole number of chunks and of one more byte
+ * or one less, in both banks.  The leaves are made up, as the tree doesn't
+ * care what was in the chunks.  The arena is a stand-in which keeps guard
+ * bytes after each allocation and checks everything is freed by the end, and
+ * that merkle_arena_size() is what merkle_init() took.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "sha1sum.c"
+#include "sha256.c"
+#include "merkle.c"
+
+#define C               MERKLE_CHUNK_SIZE
+#define GUARD           16
+#define GUARD_BYTE      0xa5
+
+static u8 arena[0x1000];
+static u32 arena_used;
+static unsigned int allocs;
+static u32 arena_taken;
+static u32 guard_at[8];         /* Of each allocation, left there once freed */
+
+void *arena_alloc(u32 size)
+{
+    void *p = arena + arena_used;
+
+    if ( arena_used + size + GUARD > sizeof(arena) )
+        abort();
+
+    if ( allocs == ARRAY_SIZE(guard_at) )
+        abort();
+
+    guard_at[allocs++] = arena_used + size;
+    arena_taken += size;
+    memset(arena + arena_used + size, GUARD_BYTE, GUARD);
+    arena_used += size + GUARD;
+
+    return p;
+}
+
+void arena_free(void *p)
+{
+    arena_used = (u8 *)p - arena;
+}
+
+static bool guards_intact(void)
+{
+    for ( unsigned int i = 0; i < allocs; i++ )
+        for ( unsigned int j = 0; j < GUARD; j++ )
+            if ( arena[guard_at[i] + j] != GUARD_BYTE )
+            {
+                printf("  Allocation %u overrun\n", i);
+                return false;
+            }
+
+    return true;
+}
+
+static const u64 sizes[] = {
+    0, 1, C - 1, C, C + 1, 2 * C, 3 * C, 5 * C + 7, 7 * C, 8 * C, 8 * C + 1,
+    13 * C + 1, 64 * C - 1, 1000 * C + 5,
+};
+
+/* Made up, but different for every leaf and bank */
+static void leaf(u64 i, u8 *sha1, u8 *sha256)
+{
+    sha1sum(sha1, &i, sizeof(i));
+    i = ~i;
+    sha256sum(sha256, &i, sizeof(i));
+}
+
+/* The tree over leaves [lo, hi), as RFC 6962 defines it */
+static void ref_tree(bool sha256, u64 lo, u64 hi, u8 *out)
+{
+    u8 buf[1 + 2 * SHA256_DIGEST_SIZE], scratch[SHA256_DIGEST_SIZE];
+    u32 size = sha256 ? SHA256_DIGEST_SIZE : SHA1_DIGEST_SIZE;
+    u64 k = 1;
+
+    if ( hi - lo == 1 )
+    {
+        if ( sha256 )
+            leaf(lo, scratch, out);
+        else
+            leaf(lo, out, scratch);
+        return;
+    }
+
+    while ( k * 2 < hi - lo )
+        k *= 2;
+
+    buf[0] = MERKLE_NODE;
+    ref_tree(sha256, lo, lo + k, buf + 1);
+    ref_tree(sha256, lo + k, hi, buf + 1 + size);
+
+    if ( sha256 )
+        sha256sum(out, buf, 1 + 2 * size);
+    else
+        sha1sum(out, buf, 1 + 2 * size);
+}
+
+static void ref_digest(bool sha256, const struct skl_merkle_event *ev,
+                       u8 *out)
+{
+    u8 buf[1 + sizeof(*ev) + SHA256_DIGEST_SIZE];
+    u32 size = sha256 ? SHA256_DIGEST_SIZE : SHA1_DIGEST_SIZE;
+
+    buf[0] = MERKLE_ROOT;
+    memcpy(buf + 1, ev, sizeof(*ev));
+    ref_tree(sha256, 0, merkle_chunks(ev->size), buf + 1 + sizeof(*ev));
+
+    if ( sha256 )
+        sha256sum(out, buf, 1 + sizeof(*ev) + size);
+    else
+        sha1sum(out, buf, 1 + sizeof(*ev) + size);
+}
+
+static bool check(u64 size, bool sha256)
+{
+    struct skl_merkle_event ev = {
+        .magic = SKL_MERKLE_MAGIC,
+        .version = SKL_MERKLE_VERSION,
+        .chunk_shift = MERKLE_CHUNK_SHIFT,
+        .size = size,
+    };
+    u8 sha1[SHA1_DIGEST_SIZE], sha256_[SHA256_DIGEST_SIZE];
+    u8 ref1[SHA1_DIGEST_SIZE], ref256[SHA256_DIGEST_SIZE];
+    u8 l1[SHA1_DIGEST_SIZE], l256[SHA256_DIGEST_SIZE];
+    u64 n = merkle_chunks(size);
+    struct merkle t;
+    bool fail = false;
+
+    if ( n != (size + C - 1) / C + (size == 0) )
+    {
+        printf("  %"PRIu64" chunks\n", n);
+        return true;
+    }
+
+    arena_used = 0;
+    allocs = 0;
+    arena_taken = 0;
+
+    merkle_init(&t, size, sha256);
+    if ( arena_taken != merkle_arena_size(size) )
+    {
+        printf("  merkle_init() took %#x bytes, not %#x\n", arena_taken,
+               merkle_arena_size(size));
+        fail = true;
+    }
+    for ( u64 i = 0; i < n; i++ )
+    {
+        leaf(i, l1, l256);
+        merkle_add(&t, l1, l256);
+    }
+    memset(sha256_, 0, sizeof(sha256_));
+    merkle_finish(&t, &ev, sha1, sha256_);
+
+    if ( allocs != 1 || arena_used != 0 )
+    {
+        printf("  %u allocations, %#x bytes left\n", allocs, arena_used);
+        fail = true;
+    }
+
+    ref_digest(false, &ev, ref1);
+    if ( memcmp(sha1, ref1, sizeof(ref1)) )
+    {
+        printf("  Wrong SHA1 digest\n");
+        fail = true;
+    }
+
+    if ( sha256 )
+    {
+        ref_digest(true, &ev, ref256);
+        if ( memcmp(sha256_, ref256, sizeof(ref256)) )
+        {
+            printf("  Wrong SHA256 digest\n");
+            fail = true;
+        }
+    }
+    else if ( memcmp(sha256_, (u8 [SHA256_DIGEST_SIZE]){}, sizeof(sha256_)) )
+    {
+        printf("  SHA256 digest written without SHA256\n");
+        fail = true;
+    }
+
+    return fail || !guards_intact();
+}
+
+int main(void)
+{
+    bool fail = false;
+
+    for ( unsigned int i = 0; i < ARRAY_SIZE(sizes); ++i )
+        for ( unsigned int b = 0; b < 2; ++b )
+        {
+            bool t_fail = check(sizes[i], b);
+
+            printf("%s: %#"PRIx64" bytes, %s\n", t_fail ? "Fail" : "Ok",
+                   sizes[i], b ? "SHA1 and SHA256" : "SHA1 only");
+            fail |= t_fail;
+        }
+
+    if ( !fail )
+        printf("All ok\n");
+
+    return fail;
+}
@@ -0,0 +1,646 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host model of the platform, for tests which include the real pci.c, dev.c
+ * and iommu.c.  It implements the hardware hooks declared by boot.h for
+ * hosted builds:
+ *
+ *  - PCI config space of bus 0, reachable both through CF8/CFC and ECAM,
+ *  - SLB protection, either as DEV (pre-17h) or MEMPROT_CR (17h),
+ *  - up to PLAT_MAX_IOMMUS IOMMUs, with their MMIO registers and a command
+ *    processor which fetches from the command buffer in host memory and
+ *    performs COMPLETION_WAIT stores,
+ *  - an IVRS listing those IOMMUs, handed out by acpi_find_table(),
+ *  - optionally, one more MMIO device plugged in by the test (the TPM model
+ *    in test-tpm.h),
+ *  - a simulated TSC, advanced by a fixed cost for every access.
+ *
+ * The costs are made up, but fixed, so latencies reported by tests only
+ * change when the code under test does something different.
+ */
+
+#ifndef __TEST_PLATFORM_H__
+#define __TEST_PLATFORM_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include <defs.h>
+#include <types.h>
+#include <boot.h>
+#include <pci.h>
+#include <dev.h>
+#include <acpi.h>
+#include <iommu.h>
+
+#define PLAT_MAX_IOMMUS     4
+
+/* Never dereferenced, every access is caught by ioread*() / iowrite*(). */
+#define PLAT_ECAM_BASE      0xe0000000U
+#define PLAT_ECAM_SIZE      0x10000000U
+#define PLAT_IOMMU_BASE     0xfeb80000U
+#define PLAT_IOMMU_SIZE     0x4000U
+
+#define PLAT_MSR_MMIO_CFG   0xc0010058
+#define PLAT_MTRRS          8
+#define PLAT_MTRR_WB        6
+
+/* Where the DEV capability lives on pre-17h parts */
+#define PLAT_DEV_CAP        0xf0
+
+/* Simulated TSC ticks */
+#define TICKS_PIO           1000
+#define TICKS_MMIO          300
+#define TICKS_RELAX         1000
+#define TICKS_CMD           2000
+#define TICKS_INV_ALL       20000
+
+struct model_iommu {
+    unsigned int bus, devfn;
+    bool fw_enabled;            /* IOMMU BAR left enabled by firmware */
+    bool iasup;
+    bool hang;                  /* Never gets around to any command */
+
+    u64 regs[PLAT_IOMMU_SIZE / 8];
+    bool stopped;               /* Command processing halted on error */
+    u64 next_cmd;               /* TSC at which the next command completes */
+
+    /* Observations */
+    unsigned int hw_errors, illegal_cmds, inv_all;
+    unsigned int completions;   /* COMPLETION_WAIT stores */
+    bool dte_inv[0x10000];      /* DTEs invalidated since DTBA write */
+};
+
+/* MMIO device provided by a test, e.g. the TPM */
+struct plat_device {
+    uintptr_t base, size;
+    u64 ticks;                  /* Cost of an access */
+    u64 (*read)(uintptr_t off, unsigned int size);
+    void (*write)(uintptr_t off, unsigned int size, u64 val);
+    void (*step)(void);         /* Called whenever the TSC moves */
+};
+
+struct plat_ivrs {
+    struct acpi_table_header hdr;
+    u8 ivinfo[IVRS_IVDB_OFFSET - sizeof(struct acpi_table_header)];
+    struct ivrs_ivhd ivhd[PLAT_MAX_IOMMUS];
+} __packed;
+
+static struct platform {
+    bool ecam;                  /* MMIO config space enabled in MSR */
+    bool dev;                   /* DEV capability rather than MEMPROT_CR */
+    bool ivrs;
+
+    u32 cf8;
+    u32 memprot_cr;
+    u32 dev_op, dev_cr;
+
+    bool present[256];          /* Functions on bus 0 */
+
+    unsigned int nr_iommus;
+    struct model_iommu iommu[PLAT_MAX_IOMMUS];
+    struct plat_ivrs ivrs_table;
+
+    const struct plat_device *device;
+
+    bool page1gb;               /* CPUID says 1G pages are supported */
+    u64 mtrr_base[PLAT_MTRRS], mtrr_mask[PLAT_MTRRS];  /* Variable MTRRs */
+    unsigned long cr3, tlb_flushes;
+
+    /* If set, die() lands here rather than aborting the test. */
+    jmp_buf *die_jmp;
+
+    u64 tsc;
+    unsigned long pio_accesses, mmio_accesses;
+} plat;
+
+static void __attribute__((noreturn)) plat_bug(const char *what, u64 val)
+{
+    fprintf(stderr, "Platform model: %s %#llx\n", what,
+            (unsigned long long)val);
+    abort();
+}
+
+static bool plat_slb_protected(void)
+{
+    if ( plat.dev )
+        return plat.dev_cr & DEV_CR_SL_DEV_EN_MASK;
+
+    return plat.memprot_cr & MEMPROT_EN;
+}
+
+/*
+ * Reset to the state SKINIT leaves behind: SLB protection on, IOMMUs set up
+ * by firmware but not by us.  IOMMU 0 is always the one at 00:00.2, the rest
+ * sit on buses 0x40, 0x80... as on multi-die parts.
+ */
+static void plat_reset(bool ecam, bool dev, bool ivrs, unsigned int nr_iommus)
+{
+    static const u8 devfns[] = {
+        PCI_DEVFN(0x00, 0), PCI_DEVFN(0x01, 0), PCI_DEVFN(0x08, 0),
+        PCI_DEVFN(0x08, 1), PCI_DEVFN(0x14, 0), PCI_DEVFN(0x14, 3),
+    };
+    unsigned int i;
+
+    memset(&plat, 0, sizeof(plat));
+
+    plat.ecam = ecam;
+    plat.dev = dev;
+    plat.ivrs = ivrs;
+    plat.nr_iommus = nr_iommus;
+    plat.page1gb = true;
+
+    /*
+     * MTRRs as firmware would set them for 3.5G of RAM below 4G: UC by
+     * default, and WB for 0-2G, 2-3G and 3-3.5G.  The fourth GB is split.
+     */
+    plat.mtrr_base[0] = 0x00000000 | PLAT_MTRR_WB;
+    plat.mtrr_mask[0] = 0xff80000000ULL | MTRR_PHYSMASK_VALID;
+    plat.mtrr_base[1] = 0x80000000 | PLAT_MTRR_WB;
+    plat.mtrr_mask[1] = 0xffc0000000ULL | MTRR_PHYSMASK_VALID;
+    plat.mtrr_base[2] = 0xc0000000 | PLAT_MTRR_WB;
+    plat.mtrr_mask[2] = 0xffe0000000ULL | MTRR_PHYSMASK_VALID;
+
+    if ( dev )
+        plat.dev_cr = DEV_CR_SL_DEV_EN_MASK;
+    else
+        plat.memprot_cr = MEMPROT_EN;
+
+    for ( i = 0; i < ARRAY_SIZE(devfns); i++ )
+        plat.present[devfns[i]] = true;
+    for ( i = 0; i < 8; i++ )
+        plat.present[PCI_DEVFN(0x18, i)] = true;
+
+    for ( i = 0; i < nr_iommus; i++ )
+    {
+        struct model_iommu *m = &plat.iommu[i];
+
+        m->bus = i * 0x40;
+        m->devfn = PCI_DEVFN(IOMMU_PCI_DEVICE, IOMMU_PCI_FUNCTION);
+        m->fw_enabled = true;
+        m->iasup = true;
+        if ( m->bus == 0 )
+            plat.present[m->devfn] = true;
+
+        plat.ivrs_table.ivhd[i] = (struct ivrs_ivhd){
+            .type = IVRS_TYPE_IVHD_11,
+            .length = sizeof(struct ivrs_ivhd),
+            .device_id = m->bus << 8 | m->devfn,
+            .capability_offset = 0x40,
+            .iommu_base_address = PLAT_IOMMU_BASE + i * PLAT_IOMMU_SIZE,
+        };
+    }
+
+    plat.ivrs_table.hdr.signature = ACPI_SIG_IVRS;
+    plat.ivrs_table.hdr.length = offsetof(struct plat_ivrs, ivhd) +
+                                 nr_iommus * sizeof(struct ivrs_ivhd);
+}
+
+static struct model_iommu *plat_iommu_at(unsigned int bus, unsigned int devfn)
+{
+    unsigned int i;
+
+    for ( i = 0; i < plat.nr_iommus; i++ )
+        if ( plat.iommu[i].bus == bus && plat.iommu[i].devfn == devfn )
+            return &plat.iommu[i];
+
+    return NULL;
+}
+
+/* PCI config space, one aligned dword at a time */
+static u32 plat_cfg_read32(unsigned int bus, unsigned int devfn,
+                           unsigned int reg)
+{
+    struct model_iommu *m = plat_iommu_at(bus, devfn);
+
+    reg &= ~3;
+
+    if ( m )
+    {
+        switch ( reg )
+        {
+        case PCI_VENDOR_ID:             return 0x14511022;
+        case PCI_CAPABILITY_LIST:       return 0x40;
+        case 0x40:                      return 0x0003000f;
+        case IOMMU_CAP_BA_LOW(0x40):
+            return (PLAT_IOMMU_BASE + (m - plat.iommu) * PLAT_IOMMU_SIZE) |
+                   m->fw_enabled;
+        default:                        return 0;
+        }
+    }
+
+    if ( bus != 0 || !plat.present[devfn] )
+        return 0xffffffff;
+
+    if ( reg == PCI_VENDOR_ID )
+        return 0x14501022;
+
+    if ( devfn == PCI_DEVFN(MCH_PCI_DEVICE, MCH_PCI_FUNCTION) &&
+         reg == MEMPROT_CR && !plat.dev )
+        return plat.memprot_cr;
+
+    if ( devfn == PCI_DEVFN(DEV_PCI_DEVICE, DEV_PCI_FUNCTION) && plat.dev )
+    {
+        switch ( reg )
+        {
+        case PCI_CAPABILITY_LIST:                   return PLAT_DEV_CAP;
+        case PLAT_DEV_CAP:
+            return PCI_CAPABILITIES_POINTER_ID_DEV;
+        case PLAT_DEV_CAP + DEV_OP_OFFSET:          return plat.dev_op;
+        case PLAT_DEV_CAP + DEV_DATA_OFFSET:
+            return plat.dev_op == DEV_CR << 8 ? plat.dev_cr : 0;
+        }
+    }
+
+    return 0;
+}
+
+static void plat_cfg_write32(unsigned int bus, unsigned int devfn,
+                             unsigned int reg, u32 val)
+{
+    reg &= ~3;
+
+    if ( bus != 0 )
+        return;
+
+    if ( devfn == PCI_DEVFN(MCH_PCI_DEVICE, MCH_PCI_FUNCTION) &&
+         reg == MEMPROT_CR && !plat.dev )
+        plat.memprot_cr = val;
+
+    if ( devfn == PCI_DEVFN(DEV_PCI_DEVICE, DEV_PCI_FUNCTION) && plat.dev )
+    {
+        if ( reg == PLAT_DEV_CAP + DEV_OP_OFFSET )
+            plat.dev_op = val;
+        else if ( reg == PLAT_DEV_CAP + DEV_DATA_OFFSET &&
+                  plat.dev_op == DEV_CR << 8 )
+            plat.dev_cr = val;
+    }
+}
+
+static u32 plat_cfg_read(unsigned int bus, unsigned int devfn,
+                         unsigned int reg, unsigned int size)
+{
+    u32 val = plat_cfg_read32(bus, devfn, reg) >> (8 * (reg & 3));
+
+    return size == 4 ? val : val & ((1U << (8 * size)) - 1);
+}
+
+/* Sub-dword writes only matter for registers nothing here models. */
+static void plat_cfg_write(unsigned int bus, unsigned int devfn,
+                           unsigned int reg, unsigned int size, u32 val)
+{
+    if ( size == 4 )
+        plat_cfg_write32(bus, devfn, reg, val);
+}
+
+/* IOMMU command processor */
+static void model_iommu_execute(struct model_iommu *m,
+                                const iommu_command_t *cmd)
+{
+    switch ( cmd->opcode )
+    {
+    case COMPLETION_WAIT:
+        if ( cmd->u0 & 1 )
+        {
+            u64 addr = ((u64)(cmd->u1 & 0xfffff) << 32) | (cmd->u0 & ~7);
+
+            *(volatile u64 *)_p(addr) = ((u64)cmd->u3 << 32) | cmd->u2;
+            m->completions++;
+        }
+        break;
+
+    case INVALIDATE_DEVTAB_ENTRY:
+        /* Beyond DevTabSize, 4K per step of its bits 8:0 */
+        if ( (cmd->u0 & 0xffff) >=
+             ((m->regs[IOMMU_MMIO_DEVICE_TABLE_BA] & 0x1ff) + 1) *
+             PAGE_SIZE / sizeof(iommu_dte_t) )
+        {
+            m->illegal_cmds++;
+            m->stopped = true;
+            break;
+        }
+        m->dte_inv[cmd->u0 & 0xffff] = true;
+        break;
+
+    case INVALIDATE_IOMMU_ALL:
+        if ( m->iasup )
+        {
+            m->inv_all++;
+            memset(m->dte_inv, true, sizeof(m->dte_inv));
+            break;
+        }
+        /* fallthrough */
+
+    default:
+        m->illegal_cmds++;
+        m->stopped = true;
+        break;
+    }
+}
+
+static u64 model_cmd_cost(const iommu_command_t *cmd)
+{
+    return cmd->opcode == INVALIDATE_IOMMU_ALL ? TICKS_INV_ALL : TICKS_CMD;
+}
+
+static void model_iommu_step(struct model_iommu *m)
+{
+    const u64 run = IOMMU_CR_IommuEn | IOMMU_CR_CmdBufEn;
+    u64 *regs = m->regs;
+
+    for ( ;; )
+    {
+        u64 ba = regs[IOMMU_MMIO_COMMAND_BUF_BA] & 0x000ffffffffff000ULL;
+        u64 size = (1ULL << ((regs[IOMMU_MMIO_COMMAND_BUF_BA] >> 56) & 0xf)) *
+                   sizeof(iommu_command_t);
+        u64 head = regs[IOMMU_MMIO_COMMAND_BUF_HEAD];
+        iommu_command_t *cmd = _p(ba + head);
+
+        if ( (regs[IOMMU_MMIO_CONTROL_REGISTER] & run) != run ||
+             m->stopped || m->hang ||
+             head == regs[IOMMU_MMIO_COMMAND_BUF_TAIL] )
+        {
+            /* Idle, whatever comes next is noticed from now on */
+            m->next_cmd = plat.tsc;
+            return;
+        }
+
+        /* The IOMMU is a PCI device, SLB protection applies to it too. */
+        if ( plat_slb_protected() )
+        {
+            m->hw_errors++;
+            m->stopped = true;
+            regs[IOMMU_MMIO_STATUS_REGISTER] |= 2;
+            return;
+        }
+
+        if ( plat.tsc < m->next_cmd + model_cmd_cost(cmd) )
+            return;
+
+        m->next_cmd += model_cmd_cost(cmd);
+        model_iommu_execute(m, cmd);
+        regs[IOMMU_MMIO_COMMAND_BUF_HEAD] = (head + sizeof(*cmd)) % size;
+    }
+}
+
+static void plat_tick(u64 ticks)
+{
+    unsigned int i;
+
+    plat.tsc += ticks;
+
+    for ( i = 0; i < plat.nr_iommus; i++ )
+        model_iommu_step(&plat.iommu[i]);
+
+    if ( plat.device && plat.device->step )
+        plat.device->step();
+}
+
+static struct model_iommu *model_iommu_mmio(uintptr_t addr, unsigned int *reg)
+{
+    unsigned int i = (addr - PLAT_IOMMU_BASE) / PLAT_IOMMU_SIZE;
+
+    if ( addr < PLAT_IOMMU_BASE || i >= plat.nr_iommus || (addr & 7) )
+        return NULL;
+
+    *reg = (addr - PLAT_IOMMU_BASE) % PLAT_IOMMU_SIZE / 8;
+    return &plat.iommu[i];
+}
+
+static void model_iommu_write(struct model_iommu *m, unsigned int reg, u64 val)
+{
+    switch ( reg )
+    {
+    case IOMMU_MMIO_EXTENDED_FEATURE:
+        return;
+
+    case IOMMU_MMIO_DEVICE_TABLE_BA:
+        memset(m->dte_inv, 0, sizeof(m->dte_inv));
+        break;
+
+    case IOMMU_MMIO_CONTROL_REGISTER:
+        if ( !(val & IOMMU_CR_CmdBufEn) )
+            m->stopped = false;
+        break;
+    }
+
+    m->regs[reg] = val;
+}
+
+static u32 plat_ecam_read(uintptr_t addr, unsigned int size)
+{
+    u32 off = addr - PLAT_ECAM_BASE;
+
+    return plat_cfg_read(off >> 20, (off >> 12) & 0xff, off & 0xfff, size);
+}
+
+static void plat_ecam_write(uintptr_t addr, unsigned int size, u32 val)
+{
+    u32 off = addr - PLAT_ECAM_BASE;
+
+    plat_cfg_write(off >> 20, (off >> 12) & 0xff, off & 0xfff, size, val);
+}
+
+static bool plat_is_ecam(uintptr_t addr)
+{
+    return plat.ecam && addr - PLAT_ECAM_BASE < PLAT_ECAM_SIZE;
+}
+
+static bool plat_is_device(uintptr_t addr)
+{
+    return plat.device && addr - plat.device->base < plat.device->size;
+}
+
+static u64 plat_mmio_read(uintptr_t addr, unsigned int size)
+{
+    struct model_iommu *m;
+    unsigned int reg;
+    u64 val;
+
+    plat.mmio_accesses++;
+
+    if ( plat_is_device(addr) )
+    {
+        plat_tick(plat.device->ticks);
+        return plat.device->read(addr - plat.device->base, size);
+    }
+
+    if ( plat_is_ecam(addr) )
+        val = plat_ecam_read(addr, size);
+    else if ( size == 8 && (m = model_iommu_mmio(addr, &reg)) )
+    {
+        val = m->regs[reg];
+        if ( reg == IOMMU_MMIO_EXTENDED_FEATURE )
+            val = m->iasup ? IOMMU_EF_IASup : 0;
+    }
+    else
+        plat_bug("unhandled MMIO read at", addr);
+
+    plat_tick(TICKS_MMIO);
+    return val;
+}
+
+static void plat_mmio_write(uintptr_t addr, unsigned int size, u64 val)
+{
+    struct model_iommu *m;
+    unsigned int reg;
+
+    plat.mmio_accesses++;
+
+    if ( plat_is_device(addr) )
+    {
+        plat.device->write(addr - plat.device->base, size, val);
+        plat_tick(plat.device->ticks);
+        return;
+    }
+
+    if ( plat_is_ecam(addr) )
+        plat_ecam_write(addr, size, val);
+    else if ( size == 8 && (m = model_iommu_mmio(addr, &reg)) )
+        model_iommu_write(m, reg, val);
+    else
+        plat_bug("unhandled MMIO write at", addr);
+
+    plat_tick(TICKS_MMIO);
+}
+
+u8  ioread8(void *addr)  { return plat_mmio_read(_u(addr), 1); }
+u16 ioread16(void *addr) { return plat_mmio_read(_u(addr), 2); }
+u32 ioread32(void *addr) { return plat_mmio_read(_u(addr), 4); }
+u64 ioread64(void *addr) { return plat_mmio_read(_u(addr), 8); }
+
+void iowrite8(u8 val, void *addr)   { plat_mmio_write(_u(addr), 1, val); }
+void iowrite16(u16 val, void *addr) { plat_mmio_write(_u(addr), 2, val); }
+void iowrite32(u32 val, void *addr) { plat_mmio_write(_u(addr), 4, val); }
+void iowrite64(u64 val, void *addr) { plat_mmio_write(_u(addr), 8, val); }
+
+/* Port I/O, only CF8/CFC config space does anything */
+static u32 plat_pio_read(u16 port, unsigned int size)
+{
+    u32 val = ~0U;
+
+    plat.pio_accesses++;
+
+    if ( port >= PCI_CONFIG_DATA_PORT && port < PCI_CONFIG_DATA_PORT + 4 &&
+         (plat.cf8 & 0x80000000) )
+        val = plat_cfg_read((plat.cf8 >> 16) & 0xff, (plat.cf8 >> 8) & 0xff,
+                       ((plat.cf8 >> 16) & 0xf00) | (plat.cf8 & 0xfc) |
+                       (port & 3), size);
+
+    plat_tick(TICKS_PIO);
+    return size == 4 ? val : val & ((1U << (8 * size)) - 1);
+}
+
+static void plat_pio_write(u16 port, unsigned int size, u32 val)
+{
+    plat.pio_accesses++;
+
+    if ( port == PCI_CONFIG_ADDR_PORT && size == 4 )
+        plat.cf8 = val;
+    else if ( port >= PCI_CONFIG_DATA_PORT && port < PCI_CONFIG_DATA_PORT + 4 &&
+              (plat.cf8 & 0x80000000) )
+        plat_cfg_write((plat.cf8 >> 16) & 0xff, (plat.cf8 >> 8) & 0xff,
+                  ((plat.cf8 >> 16) & 0xf00) | (plat.cf8 & 0xfc) | (port & 3),
+                  size, val);
+
+    plat_tick(TICKS_PIO);
+}
+
+u8  inb(u16 port) { return plat_pio_read(port, 1); }
+u16 inw(u16 port) { return plat_pio_read(port, 2); }
+u32 inl(u16 port) { return plat_pio_read(port, 4); }
+
+void outb(u8 val, u16 port)  { plat_pio_write(port, 1, val); }
+void outw(u16 val, u16 port) { plat_pio_write(port, 2, val); }
+void outl(u32 val, u16 port) { plat_pio_write(port, 4, val); }
+
+void io_delay(void)
+{
+    plat_pio_write(0x80, 1, 0);
+}
+
+u64 rdmsr(u32 msr)
+{
+    if ( msr == IA32_MTRR_CAP )
+        return PLAT_MTRRS;
+
+    if ( msr == IA32_MTRR_DEF_TYPE )
+        return MTRR_DEF_TYPE_E;             /* UC where no range says */
+
+    if ( msr >= IA32_MTRR_PHYSBASE(0) && msr < IA32_MTRR_PHYSBASE(PLAT_MTRRS) )
+        return (msr & 1 ? plat.mtrr_mask : plat.mtrr_base)[(msr & 0xff) / 2];
+
+    if ( msr != PLAT_MSR_MMIO_CFG )
+        plat_bug("unhandled RDMSR", msr);
+
+    return plat.ecam ? PLAT_ECAM_BASE | 1 : 0;
+}
+
+unsigned long read_cr3(void)
+{
+    return plat.cr3;
+}
+
+void write_cr3(unsigned long val)
+{
+    plat.cr3 = val;
+    plat.tlb_flushes++;
+}
+
+void cpuid(u32 leaf, u32 subleaf, u32 *eax, u32 *ebx, u32 *ecx, u32 *edx)
+{
+    if ( leaf != CPUID_EXT_FEATURES )
+        plat_bug("unhandled CPUID leaf", leaf);
+
+    *eax = *ebx = *ecx = 0;
+    *edx = plat.page1gb ? CPUID_EXT_EDX_PAGE1GB : 0;
+}
+
+u64 rdtsc(void)
+{
+    return plat.tsc;
+}
+
+void cpu_relax(void)
+{
+    plat_tick(TICKS_RELAX);
+}
+
+void stgi(void)
+{
+}
+
+void die(void)
+{
+    if ( plat.die_jmp )
+        longjmp(*plat.die_jmp, 1);
+
+    plat_bug("die() called at TSC", plat.tsc);
+}
+
+void *acpi_find_table(u32 signature, u32 *length)
+{
+    if ( signature != ACPI_SIG_IVRS || !plat.ivrs )
+        return NULL;
+
+    *length = plat.ivrs_table.hdr.length;
+    return &plat.ivrs_table;
+}
+
+#endif /* __TEST_PLATFORM_H__ */
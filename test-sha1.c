@@ -56,6 +56,31 @@ static void dump_hash(const u32 *hash)
         printf("%08"PRIx32, cpu_to_be32(hash[j]));
 }
 
+/* The same message fed to sha1_update() in two pieces, split at each byte */
+static bool check_split(const struct test *t)
+{
+    unsigned int len = strlen(t->msg);
+    SHA1_CONTEXT ctx;
+    u32 hash[SHA1_DIGEST_SIZE];
+    bool fail = false;
+
+    for ( unsigned int j = 0; j <= len; ++j )
+    {
+        sha1_init(&ctx);
+        sha1_update(&ctx, t->msg, j);
+        sha1_update(&ctx, t->msg + j, len - j);
+        sha1_final(&ctx, (void *)hash);
+
+        if ( memcmp(hash, t->hash, sizeof(hash)) == 0 )
+            continue;
+
+        fail = true;
+        printf("Fail: Message '%s' split at %u\n", t->msg, j);
+    }
+
+    return fail;
+}
+
 int main(void)
 {
     bool fail = false;
@@ -65,6 +90,8 @@ int main(void)
         const struct test *t = &tests[i];
         u32 hash[SHA1_DIGEST_SIZE];
 
+        fail |= check_split(t);
+
         sha1sum((void *)hash, t->msg, strlen(t->msg));
 
         if ( memcmp(hash, t->hash, sizeof(hash)) == 0 )
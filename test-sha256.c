@@ -56,6 +56,31 @@ static void dump_hash(const u64 *hash)
         printf("%016"PRIx64, cpu_to_be64(hash[j]));
 }
 
+/* The same message fed to sha256_update() in two pieces, split at each byte */
+static bool check_split(const struct test *t)
+{
+    unsigned int len = strlen(t->msg);
+    struct sha256_state ctx;
+    u64 hash[SHA256_DIGEST_SIZE];
+    bool fail = false;
+
+    for ( unsigned int j = 0; j <= len; ++j )
+    {
+        sha256_init(&ctx);
+        sha256_update(&ctx, t->msg, j);
+        sha256_update(&ctx, t->msg + j, len - j);
+        sha256_final(&ctx, (void *)hash);
+
+        if ( memcmp(hash, t->hash, sizeof(hash)) == 0 )
+            continue;
+
+        fail = true;
+        printf("Fail: Message '%s' split at %u\n", t->msg, j);
+    }
+
+    return fail;
+}
+
 int main(void)
 {
     bool fail = false;
@@ -65,6 +90,8 @@ int main(void)
         const struct test *t = &tests[i];
         u64 hash[SHA256_DIGEST_SIZE];
 
+        fail |= check_split(t);
+
         sha256sum((void *)hash, t->msg, strlen(t->msg));
 
         if ( memcmp(hash, t->hash, sizeof(hash)) == 0 )
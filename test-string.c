@@ -0,0 +1,202 @@
+/*
+ * memcpy() and memset() down each of their paths (byte loop, rep movs of
+ * words, rep movsb with ERMS and with FSRM), checked against libc for every
+ * length and misalignment up to a few hundred bytes, then timed against the
+ * byte loops they replaced.  The paths are forced by setting string_caps, so
+ * the ones the host's CPU doesn't advertise still run correctly, they just
+ * aren't representative for timing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+
+#undef memcpy
+#undef memset
+#undef strlen
+#define memcpy skl_memcpy
+#define memset skl_memset
+#define strlen skl_strlen
+
+#include "string.c"
+
+#undef memcpy
+#undef memset
+#undef strlen
+
+void cpuid(u32 leaf, u32 subleaf, u32 *eax, u32 *ebx, u32 *ecx, u32 *edx)
+{
+    asm volatile("cpuid"
+                 : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+                 : "a" (leaf), "c" (subleaf));
+}
+
+#define MAX_LEN         320
+#define MAX_MISALIGN    8
+#define GUARD           16
+#define BUF_SIZE        (2 << 20)
+#define BENCH_BYTES     (32 << 20)  /* Moved per size, per implementation */
+#define RUNS            3           /* Best of, the host is noisy */
+
+static const struct path {
+    const char *name;
+    unsigned int caps;
+} paths[] = {
+    { "words",  STRING_CAPS_KNOWN },
+    { "ERMS",   STRING_CAPS_KNOWN | STRING_CAPS_ERMS },
+    { "FSRM",   STRING_CAPS_KNOWN | STRING_CAPS_ERMS | STRING_CAPS_FSRM },
+};
+
+static const size_t bench_sizes[] = { 16, 64, 256, 4096, 65536, 1 << 20 };
+
+/* What string.c had before, kept from being turned back into libc calls */
+static noinline __attribute__((optimize("no-tree-loop-distribute-patterns")))
+void *old_memcpy(void *dst, const void *src, size_t n)
+{
+    const char *s = src;
+    char *d = dst;
+
+    while ( n-- )
+        *d++ = *s++;
+
+    return dst;
+}
+
+static noinline __attribute__((optimize("no-tree-loop-distribute-patterns")))
+void *old_memset(void *dst, int c, size_t n)
+{
+    char *d = dst;
+
+    while ( n-- )
+        *d++ = c;
+
+    return dst;
+}
+
+static u8 src[MAX_LEN + MAX_MISALIGN + 2 * GUARD];
+static u8 dst[MAX_LEN + MAX_MISALIGN + 2 * GUARD];
+static u8 ref[MAX_LEN + MAX_MISALIGN + 2 * GUARD];
+
+static bool check_path(void)
+{
+    for ( size_t len = 0; len <= MAX_LEN; ++len )
+        for ( unsigned int so = 0; so < MAX_MISALIGN; ++so )
+            for ( unsigned int doff = 0; doff < MAX_MISALIGN; ++doff )
+            {
+                u8 *d = dst + GUARD + doff, *r = ref + GUARD + doff;
+                int c = (len + so + doff) | 0x80;
+
+                memset(dst, 0x5a, sizeof(dst));
+                memset(ref, 0x5a, sizeof(ref));
+                memcpy(r, src + GUARD + so, len);
+                if ( skl_memcpy(d, src + GUARD + so, len) != d ||
+                     memcmp(dst, ref, sizeof(dst)) )
+                {
+                    printf("  memcpy(dst + %u, src + %u, %zu) wrong\n",
+                           doff, so, len);
+                    return true;
+                }
+
+                memset(r, c, len);
+                if ( skl_memset(d, c, len) != d ||
+                     memcmp(dst, ref, sizeof(dst)) )
+                {
+                    printf("  memset(dst + %u, %#x, %zu) wrong\n",
+                           doff, c, len);
+                    return true;
+                }
+            }
+
+    return false;
+}
+
+static u64 now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * (u64)1000000000 + ts.tv_nsec;
+}
+
+/* MB/s of fn over size byte chunks, walking through buf */
+static u64 bench(void *(*fn)(void *, const void *, size_t), bool set,
+                 u8 *buf, size_t size)
+{
+    size_t iters = BENCH_BYTES / size, off = 0;
+    u64 t, best = 0;
+
+    for ( unsigned int r = 0; r < RUNS; ++r )
+    {
+        t = now_ns();
+        for ( size_t i = 0; i < iters; ++i )
+        {
+            if ( set )
+                ((void *(*)(void *, int, size_t))fn)(buf + off, i, size);
+            else
+                fn(buf + off, buf + BUF_SIZE / 2 + off, size);
+            off = (off + size) % (BUF_SIZE / 2);
+        }
+        t = now_ns() - t;
+
+        if ( r == 0 || t < best )
+            best = t;
+    }
+
+    return (u64)iters * size * 1000 / (best ?: 1);
+}
+
+int main(void)
+{
+    unsigned int host_caps;
+    bool fail = false;
+    u8 *buf;
+
+    for ( unsigned int i = 0; i < sizeof(src); ++i )
+        src[i] = i * 7 + 1;
+
+    host_caps = get_string_caps();
+    printf("Host: ERMS %s, FSRM %s\n",
+           host_caps & STRING_CAPS_ERMS ? "yes" : "no",
+           host_caps & STRING_CAPS_FSRM ? "yes" : "no");
+
+    for ( unsigned int i = 0; i < ARRAY_SIZE(paths); ++i )
+    {
+        bool p_fail;
+
+        string_caps = paths[i].caps;
+        p_fail = check_path();
+        printf("%s: %s path\n", p_fail ? "Fail" : "Ok", paths[i].name);
+        fail |= p_fail;
+    }
+
+    /* Timings only mean anything for the path this CPU would take */
+    string_caps = host_caps;
+
+    buf = aligned_alloc(PAGE_SIZE, BUF_SIZE);
+    if ( !buf )
+        return 1;
+    memset(buf, 1, BUF_SIZE);
+
+    printf("%8s %12s %12s %12s %12s  (MB/s)\n",
+           "size", "old memcpy", "memcpy", "old memset", "memset");
+    for ( unsigned int i = 0; i < ARRAY_SIZE(bench_sizes); ++i )
+    {
+        size_t size = bench_sizes[i];
+
+        printf("%8zu %12"PRIu64" %12"PRIu64" %12"PRIu64" %12"PRIu64"\n", size,
+               bench(old_memcpy, false, buf, size),
+               bench(skl_memcpy, false, buf, size),
+               bench((void *)old_memset, true, buf, size),
+               bench((void *)skl_memset, true, buf, size));
+    }
+
+    free(buf);
+
+    if ( !fail )
+        printf("All ok\n");
+
+    return fail;
+}
@@ -0,0 +1,207 @@
+/*
+ * tags_index() against well formed and broken bootloader_data, and the
+ * lookups against a plain walk of the tags.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+/* crt1.o already has _start, the SLB below stands in for the linked one. */
+#define _start skl_start
+
+#include "tags.c"
+
+#define SIM_BOOTLOADER_DATA     0xf000
+#define STR(x)                  #x
+#define XSTR(x)                 STR(x)
+
+u8 sim_slb[SLB_SIZE];
+
+asm (".global skl_start, bootloader_data\n\t"
+     ".hidden skl_start, bootloader_data\n\t"
+     ".set skl_start, sim_slb\n\t"
+     ".set bootloader_data, sim_slb + " XSTR(SIM_BOOTLOADER_DATA));
+
+/* The SKL_TAG_TAGS_SIZE tag, then the ones given */
+#define TAGS(...)       { SKL_TAG_TAGS_SIZE, 4, 0, 0, __VA_ARGS__ }
+#define END             SKL_TAG_END, 2
+#define HASH(x)         SKL_TAG_SKL_HASH, 5, 0x04, 0x00, x
+#define LINUX           SKL_TAG_BOOT_LINUX, 6, 0, 0, 0, 0
+#define UNKNOWN         0x40, 3, 0
+
+static const struct test {
+    const char *name;
+    u8 data[32];
+    unsigned int size;          /* Of data, 0 for sizeof */
+    int ret;
+} tests[] = {
+    { "Well formed", TAGS(HASH(1), LINUX, UNKNOWN, HASH(2), END) },
+    { "Only the end tag", TAGS(END) },
+    { "No tags size tag", { END }, 2, -EINVAL },
+    { "Zero length tag", TAGS(HASH(1), SKL_TAG_BOOT_LINUX, 0, END), 13,
+      -EINVAL },
+    { "Tag shorter than its header", TAGS(LINUX, SKL_TAG_EVENT_LOG, 1, END),
+      14, -EINVAL },
+    { "Truncated tag", TAGS(HASH(1), SKL_TAG_BOOT_LINUX, 6, 0), 12, -EINVAL },
+    { "Truncated header", TAGS(HASH(1), SKL_TAG_BOOT_LINUX), 10, -EINVAL },
+    { "No end tag", TAGS(HASH(1), LINUX), 15, -EINVAL },
+    { "Tags after the end tag", TAGS(END, HASH(1)), 11, -EINVAL },
+};
+
+/* The SKL_TAG_* types test_lookups() checks, every one of them in tests[] */
+static const u8 types[] = {
+    SKL_TAG_TAGS_SIZE, SKL_TAG_END, SKL_TAG_BOOT_LINUX, SKL_TAG_SKL_HASH,
+    SKL_TAG_EVENT_LOG, 0x40,
+};
+
+static void load(const void *data, unsigned int size)
+{
+    u8 *t = sim_slb + SIM_BOOTLOADER_DATA;
+
+    memset(t, 0xff, SLB_SIZE - SIM_BOOTLOADER_DATA);
+    memcpy(t, data, size);
+    /* Written through sim_slb, which the compiler can't tell is aliased */
+    barrier();
+    bootloader_data.size = size;
+}
+
+/* What next_of_type() would find by walking from t to SKL_TAG_END */
+static void *walk(void *_t, u8 type)
+{
+    struct skl_tag_hdr *t = _t;
+
+    while ( t->type != SKL_TAG_END )
+    {
+        t = _p(t) + t->len;
+        if ( t->type == type )
+            return type < SKL_TAG_INDEX_TYPES ? t : NULL;
+    }
+
+    return NULL;
+}
+
+static bool check_lookups(void)
+{
+    struct skl_tag_hdr *t = (void *)&bootloader_data;
+    bool fail = false;
+    unsigned int i;
+
+    for ( ; ; t = _p(t) + t->len )
+    {
+        for ( i = 0; i < ARRAY_SIZE(types); i++ )
+            if ( next_of_type(t, types[i]) != walk(t, types[i]) )
+            {
+                printf("  next_of_type(%#tx, %#x) is %p, expected %p\n",
+                       _p(t) - _p(&bootloader_data), types[i],
+                       next_of_type(t, types[i]), walk(t, types[i]));
+                fail = true;
+            }
+
+        if ( next_of_class(t, SKL_TAG_BOOT_CLASS) !=
+             walk(t, SKL_TAG_BOOT_LINUX) )
+        {
+            printf("  next_of_class(%#tx) wrong\n",
+                   _p(t) - _p(&bootloader_data));
+            fail = true;
+        }
+
+        if ( t->type == SKL_TAG_END )
+            break;
+    }
+
+    return fail;
+}
+
+/* SKL_MAX_TAGS in all, including the first and last, and then one more */
+static bool test_max_tags(void)
+{
+    static u8 data[(SKL_MAX_TAGS + 1) * 5];
+    u8 *pos;
+    bool fail = false;
+    unsigned int i, extra;
+    int ret;
+
+    for ( extra = 0; extra < 2; extra++ )
+    {
+        pos = data;
+        *pos++ = SKL_TAG_TAGS_SIZE;
+        *pos++ = 4;
+        pos += 2;
+        for ( i = 0; i < SKL_MAX_TAGS - 2 + extra; i++ )
+        {
+            *pos++ = SKL_TAG_SKL_HASH;
+            *pos++ = 5;
+            *pos++ = 0x04;
+            *pos++ = 0x00;
+            *pos++ = i;
+        }
+        *pos++ = SKL_TAG_END;
+        *pos++ = 2;
+
+        load(data, pos - data);
+        ret = tags_index();
+        if ( ret != (extra ? -EINVAL : 0) )
+        {
+            printf("  %u tags: got %d\n", SKL_MAX_TAGS + extra, ret);
+            fail = true;
+        }
+        else if ( !extra )
+            fail |= check_lookups();
+    }
+
+    printf("%s: %u tags at most\n", fail ? "Fail" : "Ok", SKL_MAX_TAGS);
+
+    return fail;
+}
+
+int main(void)
+{
+    bool fail = false;
+    int ret;
+
+    for ( unsigned int i = 0; i < ARRAY_SIZE(tests); ++i )
+    {
+        const struct test *t = &tests[i];
+        unsigned int size = t->size;
+        bool t_fail = false;
+
+        /* Up to the end tag, when the size isn't given */
+        if ( !size )
+            for ( size = 4; t->data[size] != SKL_TAG_END;
+                  size += t->data[size + 1] )
+                ;
+        if ( !t->size )
+            size += 2;
+
+        load(t->data, size);
+        ret = tags_index();
+
+        if ( ret != t->ret )
+        {
+            printf("  Got %d, expected %d\n", ret, t->ret);
+            t_fail = true;
+        }
+        else if ( ret == 0 )
+            t_fail |= check_lookups();
+
+        printf("%s: %s\n", t_fail ? "Fail" : "Ok", t->name);
+        fail |= t_fail;
+    }
+
+    fail |= test_max_tags();
+
+    /* Reaching past the end of the SLB */
+    load(tests[0].data, 4);
+    bootloader_data.size = SLB_SIZE - SIM_BOOTLOADER_DATA + 1;
+    ret = tags_index();
+    printf("%s: Tags past the end of the SLB\n", ret == -EINVAL ? "Ok" : "Fail");
+    fail |= ret != -EINVAL;
+
+    if ( !fail )
+        printf("All ok\n");
+
+    return fail;
+}
@@ -0,0 +1,634 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host model of a TPM, plugged into test-platform.h as its MMIO device.  The
+ * test must include sha1sum.c and sha256.c first.
+ *
+ *  - TPM 1.2 or 2.0, behind either the TIS (FIFO) or the CRB interface,
+ *  - localities 0-4, granted straight away when nobody else holds one,
+ *  - TPM_Extend / TPM2_PCR_Extend, into a SHA1 and (for 2.0) a SHA256 bank,
+ *    every other command is refused,
+ *  - each command keeps the TPM busy for TICKS_TPM_CMD.  Writing commandReady
+ *    in the meantime doesn't abort it, the TPM just doesn't become ready.
+ *  - a CRB TPM takes TICKS_TPM_READY to leave idle after cmdReady, and
+ *    TICKS_TPM_IDLE to go idle after goIdle.  It starts out ready, as
+ *    firmware which used it would leave it, and takes TICKS_TPM_GRANT to
+ *    show a locality as granted.  Relinquishing the active locality sends
+ *    it back to idle, cancelling any cmdReady in flight, so the next one has
+ *    to ask for itself.
+ *  - a TIS TPM's FIFO takes TICKS_TPM_DRAIN to drain once a burst of
+ *    TPM_MODEL_BURST command bytes has filled it, with burstCount 0 meanwhile.
+ *
+ * The CRB data buffers are accessed as plain memory by tpmlib, so for CRB the
+ * model maps host memory at TPM_MMIO_BASE.  Registers still go through
+ * ioread*() / iowrite*() and never touch that memory.  Reserved registers
+ * read as all ones.
+ */
+
+#ifndef __TEST_TPM_H__
+#define __TEST_TPM_H__
+
+#include <sys/mman.h>
+
+#include "test-platform.h"
+
+#include <sha1sum.h>
+#include <sha256.h>
+#include <byteswap.h>
+#include "tpmlib/tpm.h"
+#include "tpmlib/tpm_common.h"
+#include "tpmlib/tpm2_constants.h"
+
+#define TPM_MODEL_SIZE          0x5000      /* Localities 0 to 4 */
+#define TPM_MODEL_BUF           4096
+#define TPM_MODEL_BURST         32
+#define TPM_MODEL_PCRS          24
+
+/* Simulated TSC ticks.  LPC and SPI are much slower than the IOMMU's PCIe. */
+#define TICKS_TPM_MMIO          1000
+#define TICKS_TPM_CMD           2000000     /* 2ms at 1GHz */
+#define TICKS_TPM_READY         20000000    /* 20ms */
+#define TICKS_TPM_IDLE          100000      /* 100us */
+#define TICKS_TPM_GRANT         50000       /* 50us */
+#define TICKS_TPM_DRAIN         20000       /* 20us */
+
+/* TIS registers */
+#define TIS_ACCESS              0x000
+#define TIS_INTF_CAPABILITY     0x014
+#define TIS_STS                 0x018
+#define TIS_DATA_FIFO           0x024
+#define TIS_INTERFACE_ID        0x030
+#define TIS_DID_VID             0xf00
+
+/* CRB registers */
+#define CRB_LOC_STATE           0x000
+#define CRB_LOC_CTRL            0x008
+#define CRB_LOC_STS             0x00c
+#define CRB_INTF_ID             0x030
+#define CRB_CTRL_REQ            0x040
+#define CRB_CTRL_STS            0x044
+#define CRB_CTRL_CANCEL         0x048
+#define CRB_CTRL_START          0x04c
+#define CRB_DATA_BUFFER         0x080
+
+enum model_tpm_state {
+    TPM_STATE_IDLE,
+    TPM_STATE_READY,
+    TPM_STATE_RECEPTION,
+    TPM_STATE_EXECUTION,
+    TPM_STATE_COMPLETION,
+};
+
+static struct model_tpm {
+    enum tpm_family family;
+    enum tpm_hw_intf intf;
+
+    int active;                 /* Locality, -1 if none */
+    u64 granted_at;             /* TSC at which CRB shows active as granted */
+    unsigned int requested;     /* Bitmap of localities waiting for a grant */
+
+    enum model_tpm_state state;
+    int cmd_loc;                /* Locality the command was sent from */
+    u64 done_at;                /* TSC at which the command completes */
+    u64 ready_at;               /* TSC at which cmdReady is honoured, or 0 */
+    int ready_loc;              /* Locality cmdReady came from, -1 if idle */
+    u64 idle_at;                /* TSC at which goIdle is honoured, or 0 */
+    u64 drained_at;             /* TSC at which the TIS FIFO takes bytes */
+    u8 cmd[TPM_MODEL_BUF], rsp[TPM_MODEL_BUF];
+    unsigned int cmd_len, rsp_len, rsp_pos;
+
+    u8 pcr_sha1[TPM_MODEL_PCRS][SHA1_DIGEST_SIZE];
+    u8 pcr_sha256[TPM_MODEL_PCRS][SHA256_DIGEST_SIZE];
+
+    /* Observations */
+    unsigned int commands, bad_commands;
+    u64 rsp_lag;                /* Most ticks a TIS response sat unread */
+} tpm_model;
+
+static u8 *tpm_model_crb;       /* Host memory at TPM_MMIO_BASE */
+
+static u32 get_be32(const u8 *p)
+{
+    return (u32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static u16 get_be16(const u8 *p)
+{
+    return p[0] << 8 | p[1];
+}
+
+static void put_be32(u8 *p, u32 val)
+{
+    p[0] = val >> 24; p[1] = val >> 16; p[2] = val >> 8; p[3] = val;
+}
+
+static void put_be16(u8 *p, u16 val)
+{
+    p[0] = val >> 8; p[1] = val;
+}
+
+/* PCR := H(PCR || digest), in both banks */
+static void model_pcr_extend_sha1(unsigned int pcr, const u8 *digest)
+{
+    u8 buf[2 * SHA1_DIGEST_SIZE];
+
+    memcpy(buf, tpm_model.pcr_sha1[pcr], SHA1_DIGEST_SIZE);
+    memcpy(buf + SHA1_DIGEST_SIZE, digest, SHA1_DIGEST_SIZE);
+    sha1sum(tpm_model.pcr_sha1[pcr], buf, sizeof(buf));
+}
+
+static void model_pcr_extend_sha256(unsigned int pcr, const u8 *digest)
+{
+    u8 buf[2 * SHA256_DIGEST_SIZE];
+
+    memcpy(buf, tpm_model.pcr_sha256[pcr], SHA256_DIGEST_SIZE);
+    memcpy(buf + SHA256_DIGEST_SIZE, digest, SHA256_DIGEST_SIZE);
+    sha256sum(tpm_model.pcr_sha256[pcr], buf, sizeof(buf));
+}
+
+/* The dynamic PCRs may only be extended from locality 2 and up. */
+static bool model_pcr_extendable(unsigned int pcr)
+{
+    if ( pcr >= TPM_MODEL_PCRS )
+        return false;
+
+    return pcr < 17 || tpm_model.cmd_loc >= 2;
+}
+
+/* Fill in the response header, the body is already there */
+static void model_tpm_response(u32 rc, unsigned int len)
+{
+    u16 tag = tpm_model.family == TPM12 ? 0x00c4 : rc ? 0x8001 : 0x8002;
+
+    if ( rc )
+    {
+        tpm_model.bad_commands++;
+        len = 10;
+    }
+
+    put_be16(tpm_model.rsp, tag);
+    put_be32(tpm_model.rsp + 2, len);
+    put_be32(tpm_model.rsp + 6, rc);
+    tpm_model.rsp_len = len;
+    tpm_model.rsp_pos = 0;
+}
+
+/* Returns the response code, the response length on success */
+static u32 model_tpm12_execute(const u8 *cmd, unsigned int len,
+                               unsigned int *rsp_len)
+{
+    unsigned int pcr = get_be32(cmd + 10);
+
+    if ( get_be16(cmd) != 0x00c1 || get_be32(cmd + 6) != 0x14 ||
+         len != 10 + 4 + SHA1_DIGEST_SIZE )
+        return 10;                      /* TPM_BAD_ORDINAL */
+
+    if ( !model_pcr_extendable(pcr) )
+        return 0x3d;                    /* TPM_BAD_LOCALITY */
+
+    model_pcr_extend_sha1(pcr, cmd + 14);
+
+    memcpy(tpm_model.rsp + 10, tpm_model.pcr_sha1[pcr], SHA1_DIGEST_SIZE);
+    *rsp_len = 10 + SHA1_DIGEST_SIZE;
+
+    return 0;
+}
+
+static u32 model_tpm20_execute(const u8 *cmd, unsigned int len,
+                               unsigned int *rsp_len)
+{
+    unsigned int pcr, off, count;
+
+    if ( get_be16(cmd) != 0x8002 || get_be32(cmd + 6) != 0x182 || len < 18 )
+        return 0x143;                   /* TPM_RC_COMMAND_CODE */
+
+    pcr = get_be32(cmd + 10);
+    off = 18 + get_be32(cmd + 14);      /* Skip the authorisation area */
+    if ( off + 4 > len )
+        return 0x95;                    /* TPM_RC_SIZE */
+
+    if ( !model_pcr_extendable(pcr) )
+        return 0x907;                   /* TPM_RC_LOCALITY */
+
+    for ( count = get_be32(cmd + off), off += 4; count; count-- )
+    {
+        u16 alg = off + 2 <= len ? get_be16(cmd + off) : 0;
+
+        off += 2;
+        if ( alg == TPM_ALG_SHA1 && off + SHA1_DIGEST_SIZE <= len )
+        {
+            model_pcr_extend_sha1(pcr, cmd + off);
+            off += SHA1_DIGEST_SIZE;
+        }
+        else if ( alg == TPM_ALG_SHA256 && off + SHA256_DIGEST_SIZE <= len )
+        {
+            model_pcr_extend_sha256(pcr, cmd + off);
+            off += SHA256_DIGEST_SIZE;
+        }
+        else
+            return 0x2c3;               /* TPM_RC_HASH */
+    }
+
+    /* parameterSize, then an empty password session */
+    memset(tpm_model.rsp + 10, 0, 9);
+    tpm_model.rsp[16] = 1;              /* continueSession */
+    *rsp_len = 19;
+
+    return 0;
+}
+
+static void model_tpm_start(int loc, const u8 *cmd, unsigned int len)
+{
+    if ( len > sizeof(tpm_model.cmd) )
+        len = sizeof(tpm_model.cmd);
+
+    memmove(tpm_model.cmd, cmd, len);
+    tpm_model.cmd_len = len;
+    tpm_model.cmd_loc = loc;
+    tpm_model.state = TPM_STATE_EXECUTION;
+    tpm_model.done_at = plat.tsc + TICKS_TPM_CMD;
+    tpm_model.commands++;
+}
+
+/* Finish the command, cmdReady or goIdle in flight once its time is up. */
+static void model_tpm_step(void)
+{
+    const u8 *cmd = tpm_model.cmd;
+    unsigned int len = tpm_model.cmd_len, rsp_len = 10;
+    u32 rc;
+
+    if ( tpm_model.ready_at && plat.tsc >= tpm_model.ready_at )
+    {
+        tpm_model.ready_at = 0;
+        tpm_model.state = TPM_STATE_READY;
+    }
+
+    if ( tpm_model.idle_at && plat.tsc >= tpm_model.idle_at )
+    {
+        tpm_model.idle_at = 0;
+        tpm_model.state = TPM_STATE_IDLE;
+        tpm_model.ready_loc = -1;
+    }
+
+    if ( tpm_model.state != TPM_STATE_EXECUTION ||
+         plat.tsc < tpm_model.done_at )
+        return;
+
+    if ( len < 10 || get_be32(cmd + 2) != len )
+        rc = 0x95;                      /* TPM_RC_SIZE */
+    else if ( tpm_model.family == TPM12 )
+        rc = model_tpm12_execute(cmd, len, &rsp_len);
+    else
+        rc = model_tpm20_execute(cmd, len, &rsp_len);
+
+    model_tpm_response(rc, rsp_len);
+
+    if ( tpm_model.intf == TPM_CRB )
+        memcpy(tpm_model_crb + (tpm_model.cmd_loc << 12) + CRB_DATA_BUFFER,
+               tpm_model.rsp, tpm_model.rsp_len);
+
+    tpm_model.state = TPM_STATE_COMPLETION;
+}
+
+static void model_tpm_request(int loc)
+{
+    if ( tpm_model.active < 0 )
+    {
+        tpm_model.active = loc;
+        tpm_model.granted_at = plat.tsc + TICKS_TPM_GRANT;
+    }
+    else if ( tpm_model.active != loc )
+        tpm_model.requested |= 1U << loc;
+}
+
+static void model_tpm_relinquish(int loc)
+{
+    tpm_model.requested &= ~(1U << loc);
+
+    if ( tpm_model.active != loc )
+        return;
+
+    tpm_model.active = -1;
+    if ( tpm_model.intf == TPM_CRB && tpm_model.state != TPM_STATE_EXECUTION )
+    {
+        tpm_model.state = TPM_STATE_IDLE;
+        tpm_model.ready_at = tpm_model.idle_at = 0;
+        tpm_model.ready_loc = -1;
+    }
+
+    if ( tpm_model.requested )
+    {
+        /* Highest locality wins */
+        tpm_model.active = 31 - __builtin_clz(tpm_model.requested);
+        tpm_model.requested &= ~(1U << tpm_model.active);
+        tpm_model.granted_at = plat.tsc + TICKS_TPM_GRANT;
+    }
+}
+
+/* Number of bytes the command being received still needs */
+static unsigned int tis_expected(void)
+{
+    if ( tpm_model.cmd_len < 6 )
+        return 1;
+
+    return get_be32(tpm_model.cmd + 2) > tpm_model.cmd_len;
+}
+
+static u32 tis_read(int loc, unsigned int reg)
+{
+    u32 sts = 0, burst = 0;
+
+    /* The FIFO only works for the active locality */
+    if ( (reg == TIS_STS || reg == TIS_DATA_FIFO) && tpm_model.active != loc )
+        return ~0U;
+
+    switch ( reg )
+    {
+    case TIS_ACCESS:
+        return 0x80 |                                   /* tpmRegValidSts */
+               (tpm_model.active == loc ? 0x20 : 0) |   /* activeLocality */
+               (tpm_model.requested & (1U << loc) ? 0x02 : 0);
+
+    case TIS_INTF_CAPABILITY:
+        return (tpm_model.family == TPM12 ? TPM12_TIS_INTF_13
+                                          : TPM20_TIS_INTF_13) << 28;
+
+    case TIS_STS:
+        sts = 0x80;                                     /* stsValid */
+        switch ( tpm_model.state )
+        {
+        case TPM_STATE_READY:
+            sts |= 0x40 | 0x08;                         /* commandReady */
+            burst = TPM_MODEL_BURST;
+            break;
+        case TPM_STATE_RECEPTION:
+            sts |= tis_expected() ? 0x08 : 0;           /* Expect */
+            if ( plat.tsc >= tpm_model.drained_at )
+                burst = TPM_MODEL_BURST - tpm_model.cmd_len % TPM_MODEL_BURST;
+            break;
+        case TPM_STATE_COMPLETION:
+            burst = tpm_model.rsp_len - tpm_model.rsp_pos;
+            if ( burst > TPM_MODEL_BURST )
+                burst = TPM_MODEL_BURST;
+            sts |= burst ? 0x10 : 0;                    /* dataAvail */
+            break;
+        default:
+            break;
+        }
+        return sts | burst << 8;
+
+    case TIS_DATA_FIFO:
+        if ( tpm_model.state == TPM_STATE_COMPLETION &&
+             tpm_model.rsp_pos < tpm_model.rsp_len )
+        {
+            if ( tpm_model.rsp_pos == 0 &&
+                 plat.tsc - tpm_model.done_at > tpm_model.rsp_lag )
+                tpm_model.rsp_lag = plat.tsc - tpm_model.done_at;
+            return tpm_model.rsp[tpm_model.rsp_pos++];
+        }
+        return ~0U;
+
+    case TIS_INTERFACE_ID:
+        return tpm_model.family == TPM12 ? ~0U : TPM_TIS_INTF_ACTIVE;
+
+    case TIS_DID_VID:
+        return 0x001a1050;
+
+    default:
+        return ~0U;
+    }
+}
+
+static void tis_write(int loc, unsigned int reg, u32 val)
+{
+    if ( reg == TIS_ACCESS )
+    {
+        if ( val & 0x20 )
+            model_tpm_relinquish(loc);
+        if ( val & 0x02 )
+            model_tpm_request(loc);
+        return;
+    }
+
+    if ( tpm_model.active != loc )
+        return;
+
+    switch ( reg )
+    {
+    case TIS_STS:
+        if ( (val & 0x40) && tpm_model.state != TPM_STATE_EXECUTION )
+        {
+            tpm_model.state = TPM_STATE_READY;
+            tpm_model.cmd_len = 0;
+        }
+        if ( (val & 0x20) && tpm_model.state == TPM_STATE_RECEPTION &&
+             !tis_expected() )
+            model_tpm_start(loc, tpm_model.cmd, tpm_model.cmd_len);
+        break;
+
+    case TIS_DATA_FIFO:
+        if ( (tpm_model.state == TPM_STATE_READY ||
+              tpm_model.state == TPM_STATE_RECEPTION) &&
+             tpm_model.cmd_len < sizeof(tpm_model.cmd) )
+        {
+            tpm_model.cmd[tpm_model.cmd_len++] = val;
+            tpm_model.state = TPM_STATE_RECEPTION;
+            if ( tpm_model.cmd_len % TPM_MODEL_BURST == 0 )
+                tpm_model.drained_at = plat.tsc + TICKS_TPM_DRAIN;
+        }
+        break;
+    }
+}
+
+/* The active locality, once the CRB TPM has got round to granting it */
+static int crb_active(void)
+{
+    return plat.tsc >= tpm_model.granted_at ? tpm_model.active : -1;
+}
+
+static u32 crb_read(int loc, unsigned int reg)
+{
+    switch ( reg )
+    {
+    case CRB_LOC_STATE:
+        return 0x80 | 0x01 |                /* tpmRegValidSts, established */
+               (crb_active() >= 0 ? 0x02 | crb_active() << 2 : 0);
+
+    case CRB_LOC_STS:
+        return crb_active() == loc;         /* granted */
+
+    case CRB_INTF_ID:
+        return TPM_CRB_INTF_ACTIVE | 1 << 14;   /* CapCRB */
+
+    case CRB_INTF_ID + 4:
+        return 0x001a1050;
+
+    case CRB_CTRL_REQ:                      /* cmdReady, goIdle pending */
+        return (tpm_model.ready_at != 0) | (tpm_model.idle_at != 0) << 1;
+
+    case CRB_CTRL_CANCEL:
+        return 0;
+
+    case CRB_CTRL_STS:
+        return tpm_model.state == TPM_STATE_IDLE ? 0x2 : 0;     /* tpmIdle */
+
+    case CRB_CTRL_START:
+        return tpm_model.state == TPM_STATE_EXECUTION;
+
+    default:
+        return ~0U;
+    }
+}
+
+static void crb_write(int loc, unsigned int reg, u32 val)
+{
+    if ( reg == CRB_LOC_CTRL )
+    {
+        if ( val & 0x2 )
+            model_tpm_relinquish(loc);
+        if ( val & 0x1 )
+            model_tpm_request(loc);
+        return;
+    }
+
+    if ( crb_active() != loc || tpm_model.state == TPM_STATE_EXECUTION )
+        return;
+
+    switch ( reg )
+    {
+    case CRB_CTRL_REQ:
+        if ( (val & 0x1) && tpm_model.state == TPM_STATE_IDLE )
+        {
+            if ( !tpm_model.ready_at )
+                tpm_model.ready_at = plat.tsc + TICKS_TPM_READY;
+            tpm_model.ready_loc = loc;
+        }
+        else if ( val & 0x1 )
+        {
+            tpm_model.idle_at = 0;
+            tpm_model.state = TPM_STATE_READY;
+            tpm_model.ready_loc = loc;
+        }
+        else if ( (val & 0x2) && tpm_model.state != TPM_STATE_IDLE )
+        {
+            tpm_model.ready_at = 0;
+            if ( !tpm_model.idle_at )
+                tpm_model.idle_at = plat.tsc + TICKS_TPM_IDLE;
+        }
+        break;
+
+    case CRB_CTRL_START:
+        if ( (val & 1) && tpm_model.state != TPM_STATE_IDLE )
+        {
+            const u8 *buf = tpm_model_crb + (loc << 12) + CRB_DATA_BUFFER;
+
+            model_tpm_start(loc, buf, get_be32(buf + 2));
+        }
+        break;
+    }
+}
+
+static u64 model_tpm_read(uintptr_t off, unsigned int size)
+{
+    unsigned int reg = off & 0xfff, shift = 8 * (reg & 3);
+    int loc = off >> 12;
+    u32 val;
+
+    if ( tpm_model.intf == TPM_CRB && reg >= CRB_DATA_BUFFER )
+        plat_bug("CRB data buffer accessed as MMIO at", off);
+
+    /* The FIFO hands out a byte per access, wherever in the register. */
+    if ( tpm_model.intf == TPM_TIS && (reg & ~3) == TIS_DATA_FIFO )
+        return tis_read(loc, TIS_DATA_FIFO) & 0xff;
+
+    if ( tpm_model.intf == TPM_TIS )
+        val = tis_read(loc, reg & ~3);
+    else
+        val = crb_read(loc, reg & ~3);
+
+    val >>= shift;
+    return size == 4 ? val : val & ((1U << (8 * size)) - 1);
+}
+
+static void model_tpm_write(uintptr_t off, unsigned int size, u64 val)
+{
+    unsigned int reg = off & 0xfff;
+    int loc = off >> 12;
+
+    if ( tpm_model.intf == TPM_CRB && reg >= CRB_DATA_BUFFER )
+        plat_bug("CRB data buffer accessed as MMIO at", off);
+
+    /* Nothing modelled cares about anything but the low byte(s). */
+    if ( reg & 3 )
+        return;
+
+    if ( tpm_model.intf == TPM_TIS )
+        tis_write(loc, reg, val);
+    else
+        crb_write(loc, reg, val);
+}
+
+static const struct plat_device model_tpm_device = {
+    .base = TPM_MMIO_BASE,
+    .size = TPM_MODEL_SIZE,
+    .ticks = TICKS_TPM_MMIO,
+    .read = model_tpm_read,
+    .write = model_tpm_write,
+    .step = model_tpm_step,
+};
+
+/*
+ * Plug a freshly started TPM into the platform.  Call after plat_reset().
+ * PCR17 starts out as SKINIT leaves it, i.e. extended with the hashes of the
+ * SLB (sha256 is ignored for TPM 1.2), all others are zero.
+ */
+static void model_tpm_reset(enum tpm_family family, enum tpm_hw_intf intf,
+                            const u8 *sha1, const u8 *sha256)
+{
+    memset(&tpm_model, 0, sizeof(tpm_model));
+    tpm_model.family = family;
+    tpm_model.intf = intf;
+    tpm_model.active = -1;
+    tpm_model.ready_loc = -1;
+    if ( intf == TPM_CRB )
+    {
+        /* For whichever locality firmware last used */
+        tpm_model.state = TPM_STATE_READY;
+        tpm_model.ready_loc = 0;
+    }
+
+    model_pcr_extend_sha1(17, sha1);
+    if ( family == TPM20 )
+        model_pcr_extend_sha256(17, sha256);
+
+    if ( intf == TPM_CRB && !tpm_model_crb )
+    {
+        tpm_model_crb = mmap(_p(TPM_MMIO_BASE), TPM_MODEL_SIZE,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                             -1, 0);
+        if ( tpm_model_crb != _p(TPM_MMIO_BASE) )
+            plat_bug("can't map CRB buffers at", TPM_MMIO_BASE);
+    }
+
+    if ( tpm_model_crb )
+        memset(tpm_model_crb, 0, TPM_MODEL_SIZE);
+
+    plat.device = &model_tpm_device;
+}
+
+#endif /* __TEST_TPM_H__ */
@@ -38,6 +38,9 @@
 
 static u8 locality = TPM_NO_LOCALITY;
 
+/* see tpm_get_waits() */
+struct tpm_waits crb_waits;
+
 struct tpm_loc_state {
 	union {
 		u8 val;
@@ -113,7 +116,7 @@ struct tpm_crb_intf_id_ext {
  */
 
 /* TPM Duration A: 20ms */
-static void duration_a(void)
+static void __maybe_unused duration_a(void)
 {
 	tpm_mdelay(20);
 }
@@ -130,6 +133,22 @@ static void __maybe_unused duration_c(void)
 	tpm_mdelay(1000);
 }
 
+/*
+ * Poll field until the bits in mask change from was, as tpm_poll() does,
+ * adding the TSC ticks it took to *ticks unless that's NULL.  -1 if they
+ * didn't change in time.
+ */
+static int crb_poll(u32 field, u32 mask, u32 was, int us, u64 *ticks)
+{
+	u64 start = rdtsc();
+	u32 val = tpm_poll(field, mask, was, us);
+
+	if (ticks)
+		*ticks += rdtsc() - start;
+
+	return ((val ^ was) & mask) ? 0 : -1;
+}
+
 static u8 is_idle(void)
 {
 	struct tpm_crb_ctrl_sts ctl_sts;
@@ -160,41 +179,45 @@ static u8 is_cmd_exec(void)
 	return 0;
 }
 
-static s8 cmd_ready(void)
+/* only issues the request, crb_wait_ready() waits for it to be honoured */
+static void cmd_ready(void)
 {
 	struct tpm_crb_ctrl_req ctl_req;
 
 	if (is_idle()) {
+		ctl_req.val = 0;
 		ctl_req.cmd_ready = 1;
 		tpm_write32(ctl_req.val, REGISTER(locality, TPM_CRB_CTRL_REQ));
-		tpm2_timeout_c();
-
-		if (is_idle())
-			return -1;
 	}
+}
 
-	return 0;
+/* poll for the TPM to leave idle, for at most TPM2 Timeout C (200ms) */
+int crb_wait_ready(void)
+{
+	struct tpm_crb_ctrl_sts idle = { .tpm_idle = 1 };
+
+	/* tpm_wait_ready()'s caller times this one */
+	return crb_poll(REGISTER(locality, TPM_CRB_CTRL_STS), idle.val, idle.val,
+			TPM2_TIMEOUT_C_US, NULL);
 }
 
+/* poll for the TPM to go idle, for at most TPM2 Timeout C (200ms) */
 static void go_idle(void)
 {
-	struct tpm_crb_ctrl_req ctl_req;
+	struct tpm_crb_ctrl_req ctl_req = { .go_idle = 1 };
+	struct tpm_crb_ctrl_sts idle = { .tpm_idle = 1 };
 
 	if (is_idle())
 		return;
 
-	ctl_req.go_idle = 1;
 	tpm_write32(ctl_req.val, REGISTER(locality, TPM_CRB_CTRL_REQ));
-
-	/* pause to give tpm time to complete the request */
-	tpm2_timeout_c();
+	crb_poll(REGISTER(locality, TPM_CRB_CTRL_STS), idle.val, 0,
+		 TPM2_TIMEOUT_C_US, &crb_waits.idle);
 }
 
 static void crb_relinquish_locality_internal(u16 l)
 {
-	struct tpm_loc_ctrl loc_ctrl;
-
-	loc_ctrl.relinquish = 1;
+	struct tpm_loc_ctrl loc_ctrl = { .relinquish = 1 };
 
 	tpm_write32(loc_ctrl.val, REGISTER(l, TPM_LOC_CTRL));
 }
@@ -202,8 +225,8 @@ static void crb_relinquish_locality_internal(u16 l)
 u8 crb_request_locality(u8 l)
 {
 	struct tpm_loc_state loc_state;
-	struct tpm_loc_ctrl loc_ctrl;
-	struct tpm_loc_sts loc_sts;
+	struct tpm_loc_ctrl loc_ctrl = { .request_access = 1 };
+	struct tpm_loc_sts granted = { .granted = 1 };
 
 	/* TPM_LOC_STATE is aliased across all localities */
 	loc_state.val = tpm_read8(REGISTER(0, TPM_LOC_STATE));
@@ -214,19 +237,26 @@ u8 crb_request_locality(u8 l)
 			return locality;
 		}
 
-		crb_relinquish_locality_internal(loc_state.loc_assigned);
+		crb_relinquish_locality_internal(loc_state.active_locality);
 	}
 
-	loc_ctrl.request_access = 1;
+	/* poll for the grant, for at most TPM Timeout A (750ms) */
 	tpm_write32(loc_ctrl.val, REGISTER(l, TPM_LOC_CTRL));
-
-	loc_sts.val = tpm_read32(REGISTER(l, TPM_LOC_STS));
-	if (loc_sts.granted != 1) {
+	if (crb_poll(REGISTER(l, TPM_LOC_STS), granted.val, 0, TIMEOUT_A_US,
+		     &crb_waits.grant)) {
 		locality = TPM_NO_LOCALITY;
 		return locality;
 	}
 
 	locality = l;
+
+	/*
+	 * Giving up the old locality sends the TPM back to idle, taking any
+	 * cmdReady still in flight for it along, so ask again from this one.
+	 */
+	if (loc_state.loc_assigned == 1)
+		cmd_ready();
+
 	return locality;
 }
 
@@ -257,18 +287,14 @@ size_t crb_send(struct tpmbuff *buf)
 
 	/*
 	 * Most command sequences this code is interested with operates with
-	 * 20/750 duration/timeout schedule
+	 * 20/750 duration/timeout schedule, so poll for the TPM to clear start
+	 * for that long at most.
 	 */
-	duration_a();
-	ctrl_start = tpm_read32(REGISTER(locality, TPM_CRB_CTRL_START));
-	if (ctrl_start != 0) {
-		timeout_a();
-		ctrl_start = tpm_read32(REGISTER(locality, TPM_CRB_CTRL_START));
-		if (ctrl_start != 0) {
-			cancel_send();
-			/* minimum response is header with cancel ord */
-			return sizeof(struct tpm_header);
-		}
+	if (crb_poll(REGISTER(locality, TPM_CRB_CTRL_START), ctrl_start,
+		     ctrl_start, 20000 + TIMEOUT_A_US, NULL)) {
+		cancel_send();
+		/* minimum response is header with cancel ord */
+		return sizeof(struct tpm_header);
 	}
 
 	return buf->len;
@@ -295,7 +321,7 @@ u8 crb_init(struct tpm *t)
 
 	/* have the tpm invalidate the buffer if left in completion state */
 	go_idle();
-	/* now move to ready state */
+	/* now start moving to ready state, the caller can go on meanwhile */
 	cmd_ready();
 
 	t->ops.request_locality = crb_request_locality;
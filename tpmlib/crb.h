@@ -24,5 +24,12 @@
 #include "tpm.h"
 
 u8 crb_init(struct tpm *t);
+u8 crb_request_locality(u8 l);
+void crb_relinquish_locality(void);
+size_t crb_send(struct tpmbuff *buf);
+size_t crb_recv(enum tpm_family family, struct tpmbuff *buf);
+int crb_wait_ready(void);
+
+extern struct tpm_waits crb_waits;
 
 #endif
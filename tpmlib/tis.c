@@ -28,24 +28,18 @@
 #include "tpm_common.h"
 #include "tis.h"
 
-#define TPM_BURST_MIN_DELAY 100 /* 100us */
-
 static u8 locality = TPM_NO_LOCALITY;
 
-static u32 burst_wait(void)
+/* wait for any of the bits in mask to be set in STS, see tpm_poll() */
+static u32 sts_wait(u32 mask, int us)
 {
-	u32 count = 0;
-
-	while (count == 0) {
-		count = tpm_read8(STS(locality) + 1);
-		count += tpm_read8(STS(locality) + 2) << 8;
-
-		/* Wait for FIFO to drain */
-		if (count == 0)
-			tpm_udelay(TPM_BURST_MIN_DELAY);
-	}
+	return tpm_poll(STS(locality), mask, 0, us);
+}
 
-	return count;
+/* wait for the FIFO to take or have bytes, 0 if it doesn't in time */
+static u32 burst_wait(int us)
+{
+	return (sts_wait(STS_BURST_COUNT, us) >> 8) & 0xFFFF;
 }
 
 void tis_relinquish_locality(void)
@@ -68,8 +62,9 @@ u8 tis_request_locality(u8 l)
 
 	tpm_write8(ACCESS_REQUEST_USE, ACCESS(l));
 
-	/* wait for locality to be granted */
-	if (tpm_read8(ACCESS(l)) & ACCESS_ACTIVE_LOCALITY)
+	/* wait for locality to be granted, for at most Timeout A */
+	if (tpm_poll(ACCESS(l), ACCESS_ACTIVE_LOCALITY, 0, TIMEOUT_A_US) &
+	    ACCESS_ACTIVE_LOCALITY)
 		locality = l;
 
 	return locality;
@@ -77,54 +72,58 @@ u8 tis_request_locality(u8 l)
 
 size_t tis_send(struct tpmbuff *buf)
 {
-	u8 status, *buf_ptr;
+	u32 status;
+	u8 *buf_ptr;
 	u32 burstcnt = 0;
 	u32 count = 0;
 
 	if (locality > TPM_MAX_LOCALITY)
 		return 0;
 
-	for (status = 0; (status & STS_COMMAND_READY) == 0; ) {
+	/*
+	 * Idle or Completion to Ready, within Timeout B.  A command whose
+	 * response wasn't read may still be executing, commandReady only takes
+	 * once it has completed.
+	 */
+	tpm_write8(STS_COMMAND_READY, STS(locality));
+	status = sts_wait(STS_COMMAND_READY | STS_DATA_AVAIL, TIMEOUT_B_US);
+	if (status & STS_DATA_AVAIL) {
 		tpm_write8(STS_COMMAND_READY, STS(locality));
-		status = tpm_read8(STS(locality));
+		status = sts_wait(STS_COMMAND_READY, TIMEOUT_B_US);
 	}
+	if (!(status & STS_COMMAND_READY))
+		return 0;
 
 	buf_ptr = buf->head;
 
-	/* send all but the last byte */
-	while (count < (buf->len - 1)) {
-		burstcnt = burst_wait();
-		for (; burstcnt > 0 && count < (buf->len - 1); burstcnt--) {
+	/* Reception, a burst at a time */
+	while (count < buf->len) {
+		burstcnt = burst_wait(TPM1_TIMEOUT_D_US);
+		if (burstcnt == 0)
+			return 0;
+
+		for (; burstcnt > 0 && count < buf->len; burstcnt--) {
 			tpm_write8(buf_ptr[count], DATA_FIFO(locality));
 			count++;
 		}
 
-		/* check for overflow */
-		for (status = 0; (status & STS_VALID) == 0; )
-			status = tpm_read8(STS(locality));
-
-		if ((status & STS_DATA_EXPECT) == 0)
+		/*
+		 * stsValid within Timeout C.  The TPM expects more until the
+		 * last byte, and none after it.
+		 */
+		status = sts_wait(STS_VALID, TPM1_TIMEOUT_C_US);
+		if ((status & (STS_VALID | STS_DATA_EXPECT)) !=
+		    (count < buf->len ? STS_VALID | STS_DATA_EXPECT : STS_VALID))
 			return 0;
 	}
 
-	/* write last byte */
-	tpm_write8(buf_ptr[buf->len - 1], DATA_FIFO(locality));
-	count++;
-
-	/* make sure it stuck */
-	for (status = 0; (status & STS_VALID) == 0; )
-		status = tpm_read8(STS(locality));
-
-	if ((status & STS_DATA_EXPECT) != 0)
-		return 0;
-
-	/* go and do it */
+	/* go and do it, Reception to Execution */
 	tpm_write8(STS_GO, STS(locality));
 
 	return (size_t)count;
 }
 
-static size_t recv_data(unsigned char *buf, size_t len)
+static size_t recv_data(unsigned char *buf, size_t len, int us)
 {
 	size_t size = 0;
 	u8 *bufptr;
@@ -133,7 +132,10 @@ static size_t recv_data(unsigned char *buf, size_t len)
 	bufptr = (u8 *)buf;
 
 	while (tis_data_available(locality) && size < len) {
-		burstcnt = burst_wait();
+		burstcnt = burst_wait(us);
+		if (burstcnt == 0)
+			break;
+
 		for (; burstcnt > 0 && size < len; burstcnt--) {
 			*bufptr = tpm_read8(DATA_FIFO(locality));
 			bufptr++;
@@ -146,6 +148,7 @@ static size_t recv_data(unsigned char *buf, size_t len)
 
 size_t tis_recv(enum tpm_family f, struct tpmbuff *buf)
 {
+	int us = f == TPM12 ? TPM1_TIMEOUT_D_US : TPM2_TIMEOUT_D_US;
 	u32 expected;
 	u8 *buf_ptr;
 	struct tpm_header *hdr;
@@ -153,21 +156,13 @@ size_t tis_recv(enum tpm_family f, struct tpmbuff *buf)
 	if (locality > TPM_MAX_LOCALITY)
 		return 0;
 
-	/* ensure that there is data available */
-	if (!tis_data_available(locality)) {
-		if (f == TPM12)
-			tpm1_timeout_d();
-		else
-			tpm2_timeout_d();
-
-		if (!tis_data_available(locality))
-			return 0;
-	}
+	/* wait for data, Execution to Completion, recv_data() checks it came */
+	sts_wait(STS_DATA_AVAIL, us);
 
 	/* read header */
 	hdr = (struct tpm_header *)buf->head;
 	expected = sizeof(struct tpm_header);
-	if (recv_data(buf->head, expected) < expected)
+	if (recv_data(buf->head, expected, us) < expected)
 		return 0;
 
 	/* convert header */
@@ -185,16 +180,8 @@ size_t tis_recv(enum tpm_family f, struct tpmbuff *buf)
 	if (!buf_ptr)
 		return 0;
 
-	/* read all data, except last byte */
-	if (recv_data(buf_ptr, expected - 1) < (expected - 1))
-		return 0;
-
-	/* check for receive underflow */
-	if (!tis_data_available(locality))
-		return 0;
-
-	/* read last byte */
-	if (recv_data(buf_ptr, 1) != 1)
+	/* read all data */
+	if (recv_data(buf_ptr, expected, us) < expected)
 		return 0;
 
 	/* make sure we read everything */
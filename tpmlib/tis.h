@@ -36,6 +36,7 @@
 #define STS_DATA_AVAIL			0x10 /* (R) */
 #define STS_DATA_EXPECT			0x08 /* (R) */
 #define STS_GO				0x20 /* (W) */
+#define STS_BURST_COUNT			0xFFFF00 /* (R) */
 
 static inline bool tis_data_available(int locality)
 {
@@ -47,5 +48,9 @@ static inline bool tis_data_available(int locality)
 }
 
 u8 tis_init(struct tpm *t);
+u8 tis_request_locality(u8 l);
+void tis_relinquish_locality(void);
+size_t tis_send(struct tpmbuff *buf);
+size_t tis_recv(enum tpm_family f, struct tpmbuff *buf);
 
 #endif
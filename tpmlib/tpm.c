@@ -65,7 +65,11 @@ struct tpm *enable_tpm(void)
 
 	find_interface_and_family(t);
 
-	switch (t->intf) {
+	/* A build for one kind of TPM can't drive any other */
+	if (TPM_INTF(t->intf) != t->intf || TPM_FAMILY(t->family) != t->family)
+		return NULL;
+
+	switch (TPM_INTF(t->intf)) {
 	case TPM_TIS:
 		if (!tis_init(t))
 			return NULL;
@@ -83,19 +87,41 @@ u8 tpm_request_locality(struct tpm *t, u8 l)
 {
 	u8 ret = TPM_NO_LOCALITY;
 
-	ret = t->ops.request_locality(l);
+	ret = TPM_OP(t, request_locality)(l);
 
 	if (ret < TPM_MAX_LOCALITY)
-		t->buff = alloc_tpmbuff(t->intf, ret);
+		t->buff = alloc_tpmbuff(TPM_INTF(t->intf), ret);
 
 	return ret;
 }
 
 void tpm_relinquish_locality(struct tpm *t)
 {
-	t->ops.relinquish_locality();
+	TPM_OP(t, relinquish_locality)();
+
+	free_tpmbuff(t->buff, TPM_INTF(t->intf));
+}
+
+/*
+ * enable_tpm() only starts the interface's transition to accepting commands,
+ * this must be called before the first one is sent.
+ */
+int tpm_wait_ready(struct tpm *t)
+{
+	/* TIS has nothing to wait for */
+	if (TPM_INTF(t->intf) != TPM_CRB)
+		return 0;
+
+	return crb_wait_ready();
+}
+
+/* NULL if the interface doesn't keep count, as TIS doesn't */
+const struct tpm_waits *tpm_get_waits(struct tpm *t)
+{
+	if (TPM_INTF(t->intf) != TPM_CRB)
+		return NULL;
 
-	free_tpmbuff(t->buff, t->intf);
+	return &crb_waits;
 }
 
 #define MAX_TPM_EXTEND_SIZE 70 /* TPM2 SHA512 is the largest */
@@ -107,7 +133,7 @@ int tpm_extend_pcr(struct tpm *t, u32 pcr, u16 algo,
 	if (t->buff == NULL)
 		return -EINVAL;
 
-	if (t->family == TPM12) {
+	if (TPM_FAMILY(t->family) == TPM12) {
 		struct tpm_digest d;
 
 		if (algo != TPM_ALG_SHA1)
@@ -118,7 +144,7 @@ int tpm_extend_pcr(struct tpm *t, u32 pcr, u16 algo,
 			digest, SHA1_DIGEST_SIZE);
 
 		ret = tpm1_pcr_extend(t, &d);
-	} else if (t->family == TPM20) {
+	} else if (TPM_FAMILY(t->family) == TPM20) {
 		struct tpml_digest_values *d;
 		u8 buf[MAX_TPM_EXTEND_SIZE];
 
@@ -43,6 +43,15 @@ struct tpm_hw_ops {
 	size_t (*recv)(enum tpm_family family, struct tpmbuff *buf);
 };
 
+/*
+ * TSC ticks an interface has spent so far waiting for localities to be
+ * granted, and for the TPM to go idle, for the caller to log.
+ */
+struct tpm_waits {
+	u64 grant;
+	u64 idle;
+};
+
 struct tpm {
 	u32 vendor;
 	enum tpm_family family;
@@ -51,9 +60,36 @@ struct tpm {
 	struct tpmbuff *buff;
 };
 
+/*
+ * A build for one kind of TPM (TPM_INTF= and TPM_FAMILY= to make) knows its
+ * interface and family at compile time.  TPM_INTF() and TPM_FAMILY() are
+ * then constants, so branches on them fold away, and TPM_OP() calls the one
+ * interface's function directly rather than through t->ops.
+ */
+#if defined(CONFIG_TPM_TIS)
+#define TPM_INTF(i)	TPM_TIS
+#define TPM_OP(t, op)	tis_##op
+#elif defined(CONFIG_TPM_CRB)
+#define TPM_INTF(i)	TPM_CRB
+#define TPM_OP(t, op)	crb_##op
+#else
+#define TPM_INTF(i)	(i)
+#define TPM_OP(t, op)	(t)->ops.op
+#endif
+
+#if defined(CONFIG_TPM12)
+#define TPM_FAMILY(f)	TPM12
+#elif defined(CONFIG_TPM20)
+#define TPM_FAMILY(f)	TPM20
+#else
+#define TPM_FAMILY(f)	(f)
+#endif
+
 extern struct tpm *enable_tpm(void);
 extern u8 tpm_request_locality(struct tpm *t, u8 l);
 extern void tpm_relinquish_locality(struct tpm *t);
+extern int tpm_wait_ready(struct tpm *t);
+extern const struct tpm_waits *tpm_get_waits(struct tpm *t);
 extern int tpm_extend_pcr(struct tpm *t, u32 pcr, u16 algo,
 		u8 *digest);
 extern void free_tpm(struct tpm *t);
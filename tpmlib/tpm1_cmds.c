@@ -28,6 +28,7 @@
 #include "tpm.h"
 #include "tpmbuff.h"
 #include "tis.h"
+#include "crb.h"
 #include "tpm_common.h"
 #include "tpm1.h"
 
@@ -69,7 +70,7 @@ int tpm1_pcr_extend(struct tpm *t, struct tpm_digest *d)
 
 	hdr->size = cpu_to_be32(tpmb_size(b));
 
-	if (be32_to_cpu(hdr->size) != t->ops.send(b)) {
+	if (be32_to_cpu(hdr->size) != TPM_OP(t, send)(b)) {
 		ret = -EAGAIN;
 		goto free;
 	}
@@ -86,7 +87,7 @@ int tpm1_pcr_extend(struct tpm *t, struct tpm_digest *d)
 	 */
 
 	/* recv() will increase the buffer size */
-	size = t->ops.recv(t->family, b);
+	size = TPM_OP(t, recv)(TPM_FAMILY(t->family), b);
 	if (tpmb_size(b) != size) {
 		ret = -EAGAIN;
 		goto free;
@@ -149,7 +149,7 @@ int tpm2_extend_pcr(struct tpm *t, u32 pcr,
 
 	cmd.header->size = cpu_to_be32(tpmb_size(b));
 
-	size = t->ops.send(b);
+	size = TPM_OP(t, send)(b);
 	if (tpmb_size(b) != size)
 		ret = -EAGAIN;
 
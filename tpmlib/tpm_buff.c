@@ -20,12 +20,17 @@
 #endif
 
 #include <string.h>
+#include <arena.h>
 
 #include "tpm.h"
 #include "tpmbuff.h"
 #include "tpm_common.h"
 
-#define STATIC_TIS_BUFFER_SIZE		1024
+/*
+ * Only PCR extends are ever sent, the largest being SKL's TPM2 SHA1 and
+ * SHA256 extend at 87 bytes.  It comes from the arena, and only for TIS.
+ */
+#define STATIC_TIS_BUFFER_SIZE		128
 
 #define TPM_CRB_DATA_BUFFER_OFFSET	0x80
 #define TPM_CRB_DATA_BUFFER_SIZE	3966
@@ -84,19 +89,18 @@ size_t tpmb_size(struct tpmbuff *b)
 	return b->len;
 }
 
-static u8 tis_buff[STATIC_TIS_BUFFER_SIZE];
 static struct tpmbuff tpm_buff;
 
 struct tpmbuff *alloc_tpmbuff(enum tpm_hw_intf intf, u8 locality)
 {
 	struct tpmbuff *b = &tpm_buff;
 
-	switch (intf) {
+	switch (TPM_INTF(intf)) {
 	case TPM_TIS:
 		if (b->head)
 			goto reset;
 
-		b->head = (u8 *)&tis_buff;
+		b->head = arena_alloc(STATIC_TIS_BUFFER_SIZE);
 		b->truesize = STATIC_TIS_BUFFER_SIZE;
 		break;
 	case TPM_CRB:
@@ -120,8 +124,10 @@ reset:
 
 void free_tpmbuff(struct tpmbuff *b, enum tpm_hw_intf intf)
 {
-	switch (intf) {
+	switch (TPM_INTF(intf)) {
 	case TPM_TIS:
+		if (b->head)
+			arena_free(b->head);
 		b->head = NULL;
 		break;
 	case TPM_CRB:
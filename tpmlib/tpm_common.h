@@ -126,9 +126,18 @@ static inline void tpm2_timeout_d(void)
 	tpm_mdelay(30);
 }
 
+/* The same timeouts in microseconds, as deadlines for tpm_poll() */
+#define TIMEOUT_A_US		750000
+#define TIMEOUT_B_US		2000000
+#define TPM1_TIMEOUT_C_US	750000
+#define TPM1_TIMEOUT_D_US	750000
+#define TPM2_TIMEOUT_C_US	200000
+#define TPM2_TIMEOUT_D_US	30000
+
 u8 tpm_read8(u32 field);
 void tpm_write8(unsigned char val, u32 field);
 u32 tpm_read32(u32 field);
 void tpm_write32(unsigned int val, u32 field);
+u32 tpm_poll(u32 field, u32 mask, u32 was, int us);
 
 #endif
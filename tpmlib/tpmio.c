@@ -15,10 +15,18 @@
 #include "tpm.h"
 #include "tpm_common.h"
 
+/* Longest delay between reads in tpm_poll() */
+#define TPM_POLL_MAX_DELAY 64 /* 64us */
+
 static noinline void tpm_io_delay(void)
 {
+#if __STDC_HOSTED__
+	/* Host tests account for the time in their platform model */
+	io_delay();
+#else
 	/* This is the default delay type in native_io_delay */
 	asm volatile ("outb %al, $0x80");
+#endif
 }
 
 void tpm_udelay(int loops)
@@ -62,3 +70,24 @@ void tpm_write32(unsigned int val, u32 field)
 
 	iowrite32(val, mmio_addr);
 }
+
+/*
+ * Poll field until any of the bits in mask read other than they do in was,
+ * for at most us microseconds, and return what was read last.  The delay
+ * between reads starts out at 1us and doubles up to TPM_POLL_MAX_DELAY, so a
+ * fast TPM is seen at about its own latency while a slow one isn't hammered.
+ */
+u32 tpm_poll(u32 field, u32 mask, u32 was, int us)
+{
+	int delay = 1;
+	u32 val;
+
+	while ((((val = tpm_read32(field)) ^ was) & mask) == 0 && us > 0) {
+		tpm_udelay(delay);
+		us -= delay;
+		if (delay < TPM_POLL_MAX_DELAY)
+			delay *= 2;
+	}
+
+	return val;
+}
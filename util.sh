@@ -24,6 +24,10 @@ sha256_skl () {
 	dd if="$SLB_FILE" bs=1 count=$SL_SIZE 2>/dev/null | sha256sum | grep -o "^[a-fA-F0-9]*"
 }
 
+sha384_skl () {
+	dd if="$SLB_FILE" bs=1 count=$SL_SIZE 2>/dev/null | sha384sum | grep -o "^[a-fA-F0-9]*"
+}
+
 validate_and_escape_hash () {
 	local TRIM=`echo -n "$1" | sed -r -e "s/ .*//"`
 	if (( ${#TRIM} != 64 && ${#TRIM} != 40 )); then